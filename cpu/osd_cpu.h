@@ -25,19 +25,19 @@
 #ifndef OSD_CPU_H
 #define OSD_CPU_H
 
-#if !defined(DOS) && !defined(PSP)
+#if !defined(DOS) && !defined(PSP) && !defined(LINUX)
 #include "basetsd.h"
 #endif
 
 typedef unsigned char						UINT8;
 typedef unsigned short						UINT16;
-#if defined(DOS) || defined(PSP)
+#if defined(DOS) || defined(PSP) || defined(LINUX)
 typedef unsigned int                        UINT32;
 __extension__ typedef unsigned long long    UINT64;
 #endif
 typedef signed char 						INT8;
 typedef signed short						INT16;
-#if defined(DOS) || defined(PSP)
+#if defined(DOS) || defined(PSP) || defined(LINUX)
 typedef signed int                          INT32;
 __extension__ typedef signed long long      INT64;
 #endif
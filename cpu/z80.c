@@ -72,6 +72,34 @@
  *		http://www.msxnet.org/tech/Z80/z80undoc.txt
  *****************************************************************************/
 
+/* Built again as z80_<name>_xxx() by each variant in z80_*.c, which
+   sets its options and Z80_CORE to the name before including this file */
+#ifdef Z80_CORE
+#ifndef Z80_CORES
+#define Z80_CORES
+#endif
+#define Z80_CORE_FN(fn) 		Z80_CORE_FN2(Z80_CORE,fn)
+#define Z80_CORE_FN2(core,fn)	Z80_CORE_FN3(core,fn)
+#define Z80_CORE_FN3(core,fn)	z80_##core##_##fn
+#define Z80_CORE_STR(core)		Z80_CORE_STR2(core)
+#define Z80_CORE_STR2(core) 	#core
+#define z80_icache_init 		Z80_CORE_FN(icache_init)
+#define z80_init				Z80_CORE_FN(init)
+#define z80_reset				Z80_CORE_FN(reset)
+#define z80_exit				Z80_CORE_FN(exit)
+#define z80_execute 			Z80_CORE_FN(execute)
+#define z80_burn				Z80_CORE_FN(burn)
+#define z80_get_context 		Z80_CORE_FN(get_context)
+#define z80_set_context 		Z80_CORE_FN(set_context)
+#define z80_remap				Z80_CORE_FN(remap)
+#define z80_get_cycle_table 	Z80_CORE_FN(get_cycle_table)
+#define z80_set_cycle_table 	Z80_CORE_FN(set_cycle_table)
+#define z80_get_reg 			Z80_CORE_FN(get_reg)
+#define z80_set_reg 			Z80_CORE_FN(set_reg)
+#define z80_set_irq_line		Z80_CORE_FN(set_irq_line)
+#define z80_set_irq_callback	Z80_CORE_FN(set_irq_callback)
+#endif
+
 #include "shared.h"
 #include "z80.h"
 #include "cpuintrf.h"
@@ -91,36 +119,140 @@
 #define LOG(x)
 #endif
 
-int z80_exec = 0;               // 1= in exec loop, 0= out of
-int z80_cycle_count = 0;        // running total of cycles executed
-int z80_requested_cycles = 0;   // requested cycles to execute this timeslice
+#ifndef Z80_CORE
+THREAD_LOCAL int z80_exec = 0;              // 1= in exec loop, 0= out of
+THREAD_LOCAL int z80_cycle_count = 0;       // running total of cycles executed
+THREAD_LOCAL int z80_requested_cycles = 0;  // requested cycles to execute this timeslice
+
+THREAD_LOCAL void (*cpu_writemem16)(int address, int data);
+THREAD_LOCAL void (*cpu_writeport16)(uint16 port, uint8 data);
+THREAD_LOCAL uint8 (*cpu_readport16)(uint16 port);
+THREAD_LOCAL unsigned char *cpu_readmap[64];
+THREAD_LOCAL unsigned char *cpu_writemap[64];
+THREAD_LOCAL unsigned char cpu_writeattr[64];
+#else
+/* the memory map, hooks and cycle counts are shared with z80.c */
+extern THREAD_LOCAL int z80_exec;
+extern THREAD_LOCAL int z80_cycle_count;
+extern THREAD_LOCAL int z80_requested_cycles;
+#endif
 
-extern void (*cpu_writemem16)(int address, int data);
-extern void (*cpu_writeport)(int port, int data);
-extern int (*cpu_readport)(int port);
-unsigned char *cpu_readmap[64];
-unsigned char *cpu_writemap[64];
+#if defined(Z80_CORES) && !defined(Z80_CORE)
+/* variant selected by z80_select_core(), NULL runs this build */
+THREAD_LOCAL const z80_core_t *z80_core = NULL;
+
+#define Z80_FORWARD(fn,args)		{ if( z80_core ) return (*z80_core->fn)args; }
+#define Z80_FORWARD_VOID(fn,args)	{ if( z80_core ) { (*z80_core->fn)args; return; } }
+#else
+#define Z80_FORWARD(fn,args)
+#define Z80_FORWARD_VOID(fn,args)
+#endif
+
+#ifdef Z80_PROFILE
+#ifndef Z80_CORE
+THREAD_LOCAL UINT32 z80_op_count[Z80_PROF_MAX][256];	/* executions of each opcode */
+THREAD_LOCAL void (*z80_profile_insn)(int pc, int cycles) = NULL;
+THREAD_LOCAL void (*z80_profile_call)(int pc, int target) = NULL;
+THREAD_LOCAL void (*z80_profile_ret)(int sp) = NULL;
+#endif
+
+#define PROFILE_OP(prefix,op)	z80_op_count[Z80_PROF_##prefix][op]++
+#define PROFILE_CALL(target)	{ if( z80_profile_call ) (*z80_profile_call)(_PPC, target); }
+#define PROFILE_RET()			{ if( z80_profile_ret ) (*z80_profile_ret)(_SPD); }
+#else
+#define PROFILE_OP(prefix,op)
+#define PROFILE_CALL(target)
+#define PROFILE_RET()
+#endif
 
 #define cpu_readmem16(a)        cpu_readmap[(a) >> 10][(a) & 0x03FF]
 #define cpu_readop(a)           cpu_readmap[(a) >> 10][(a) & 0x03FF]
 #define cpu_readop_arg(a)       cpu_readmap[(a) >> 10][(a) & 0x03FF]
 
+/* The 1K page the PC is in. Opcodes and operands are read through
+   code_ptr while the PC stays in the page; z80_remap() drops it
+   whenever cpu_readmap[] changes */
+static THREAD_LOCAL UINT8 *code_ptr;
+static THREAD_LOCAL unsigned code_page = ~0U;
+
 /* execute main opcodes inside a big switch statement */
 #ifndef BIG_SWITCH
 #define BIG_SWITCH			1
 #endif
 
+/* dispatch opcodes through GCC computed gotos (threaded code) */
+#ifndef Z80_THREADED
+#define Z80_THREADED		0
+#endif
+#if Z80_THREADED && !defined(__GNUC__)
+#undef Z80_THREADED
+#define Z80_THREADED		0
+#endif
+
+/* run code in ROM from a cache of pre-decoded instructions,
+   not used by the threaded dispatch */
+#ifndef Z80_ICACHE
+#define Z80_ICACHE			0
+#endif
+
 /* big flags array for ADD/ADC/SUB/SBC/CP results */
 #define BIG_FLAGS_ARRAY     0
 
 /* Set to 1 for a more exact (but somewhat slower) Z80 emulation */
+#ifndef Z80_EXACT
 #define Z80_EXACT			1
+#endif
 
 /* on JP and JR opcodes check for tight loops */
+#ifndef BUSY_LOOP_HACKS
 #define BUSY_LOOP_HACKS 	1
+#endif
 
 /* check for delay loops counting down BC */
+#ifndef TIME_LOOP_HACKS
 #define TIME_LOOP_HACKS     1
+#endif
+
+/* support for daisy chained interrupt devices (Z80_DaisyChain passed
+   to z80_reset). Nothing on the SMS or GG uses it */
+#ifndef Z80_DAISY_CHAIN
+#define Z80_DAISY_CHAIN 	1
+#endif
+
+/* keep the previous program counter (REG_PREVIOUSPC) up to date on
+   every instruction. Always on when profiling, which reports by it */
+#ifdef Z80_PROFILE
+#undef	Z80_TRACK_PPC
+#define Z80_TRACK_PPC		1
+#endif
+#ifndef Z80_TRACK_PPC
+#define Z80_TRACK_PPC		1
+#endif
+
+/* on backward branches check for loops without side effects, such as
+   games polling RAM or the VDP status while waiting for an interrupt.
+   Not used when profiling, the skipped iterations would go uncounted */
+#ifdef Z80_PROFILE
+#undef	IDLE_LOOP_HACKS
+#define IDLE_LOOP_HACKS 	0
+#endif
+#ifndef IDLE_LOOP_HACKS
+#define IDLE_LOOP_HACKS 	1
+#endif
+
+/* identical iterations seen before the rest of the time slice is skipped */
+#define IDLE_LOOP_COUNT 	2
+
+/* on OTIR, INIR and runs of OUTI hand the bytes to the port in one go
+   when it can take them. Not used when profiling, the instructions
+   done in one go would go uncounted */
+#ifdef Z80_PROFILE
+#undef	BLOCK_IO_HACKS
+#define BLOCK_IO_HACKS		0
+#endif
+#ifndef BLOCK_IO_HACKS
+#define BLOCK_IO_HACKS		1
+#endif
 
 #ifdef X86_ASM
 #undef	BIG_FLAGS_ARRAY
@@ -142,6 +274,18 @@ unsigned char *cpu_writemap[64];
 
 #define _PPC	Z80.PREPC.d 	/* previous program counter */
 
+#if Z80_TRACK_PPC
+#define TRACK_PPC	_PPC = _PCD
+#else
+#define TRACK_PPC
+#endif
+
+#if Z80_DAISY_CHAIN
+#define DAISY_PENDING	(Z80.request_irq >= 0)
+#else
+#define DAISY_PENDING	0
+#endif
+
 #define _PCD	Z80.PC.d
 #define _PC 	Z80.PC.w.l
 
@@ -192,11 +336,56 @@ unsigned char *cpu_writemap[64];
 	#define	Z80_ICOUNT	z80_ICount
 #endif
 
-int Z80_ICOUNT;
-static Z80_Regs Z80;
-Z80_Regs *Z80_Context = &Z80;
-static UINT32 EA;
-int after_EI = 0;
+#ifndef Z80_CORE
+THREAD_LOCAL int Z80_ICOUNT;
+THREAD_LOCAL Z80_Regs *Z80_Context;
+#endif
+static THREAD_LOCAL Z80_Regs Z80;
+static THREAD_LOCAL UINT32 EA;
+
+#if Z80_ICACHE
+/* A decoded instruction: its prefix and opcode, with the handler to run */
+typedef struct {
+	void	(*handler)(void);	/* handler of the last opcode byte		*/
+	UINT8	cycles; 		/* T-states of the prefix and opcode		*/
+	UINT8	length; 		/* opcode bytes, also the R increment		*/
+	UINT8	prefix; 		/* 0xcb/0xdd/0xed/0xfd, or 0 if none		*/
+	UINT8	op;
+}	Z80_Decoded;
+
+static THREAD_LOCAL UINT8 *icache_rom;				/* code that may be cached */
+static THREAD_LOCAL int icache_size;
+static THREAD_LOCAL Z80_Decoded **icache_page;		/* per 1K of ROM, allocated on first use */
+static THREAD_LOCAL UINT8 *icache_tag[64];			/* cpu_readmap[] the slot was set up for */
+static THREAD_LOCAL Z80_Decoded *icache_slot[64];	/* decoded page mapped in each slot */
+#endif
+
+#ifndef Z80_CORE
+THREAD_LOCAL int after_EI = 0;
+
+/* returns non-zero if reading a port has no side effects and gives
+   the same value for the rest of the time slice */
+THREAD_LOCAL int (*cpu_idleport16)(uint16 port) = NULL;
+
+/* returns non-zero if the taken backward branch at pc is known to
+   close a loop that only waits for the next time slice */
+THREAD_LOCAL int (*cpu_idlepc16)(uint16 pc) = NULL;
+
+/* write or read 'len' bytes at a port in one go, as that many OUT or IN
+   would; return zero if the port needs them one at a time */
+THREAD_LOCAL int (*cpu_writeblock16)(uint16 port, const uint8 *src, int len) = NULL;
+THREAD_LOCAL int (*cpu_readblock16)(uint16 port, uint8 *dst, int len) = NULL;
+#endif
+
+#if IDLE_LOOP_HACKS
+static THREAD_LOCAL UINT32 idle_pc = -1;	/* backward branch being watched */
+static THREAD_LOCAL Z80_Regs idle_regs; 	/* registers when it was last taken */
+static THREAD_LOCAL int idle_icount;
+static THREAD_LOCAL int idle_requested; 	/* lowered when z80_end_slice() cuts the slice */
+static THREAD_LOCAL UINT8 idle_r;
+static THREAD_LOCAL int idle_count; 		/* identical iterations seen */
+static THREAD_LOCAL int idle_dirty; 		/* memory written or port accessed */
+#endif
 
 static UINT8 SZ[256];		/* zero and sign flags */
 static UINT8 SZ_BIT[256];	/* zero, sign and parity/overflow (=zero) flags for BIT opcode */
@@ -498,6 +687,7 @@ MAME_INLINE void BURNODD(int cycles, int opcodes, int cyclesum)
 {																\
 	unsigned op = opcode;										\
 	CC(prefix,op);												\
+	PROFILE_OP(prefix,op);										\
 	(*Z80##prefix[op])();										\
 }
 
@@ -506,6 +696,7 @@ MAME_INLINE void BURNODD(int cycles, int opcodes, int cyclesum)
 {																\
 	unsigned op = opcode;										\
 	CC(prefix,op);												\
+	PROFILE_OP(prefix,op);										\
 	switch(op)													\
 	{															\
 	case 0x00:prefix##_##00();break; case 0x01:prefix##_##01();break; case 0x02:prefix##_##02();break; case 0x03:prefix##_##03();break; \
@@ -579,6 +770,279 @@ MAME_INLINE void BURNODD(int cycles, int opcodes, int cyclesum)
 #endif
 
 
+/***************************************************************
+ * Threaded code: every handler ends with its own dispatch
+ * through a table of GCC label addresses. Prefixes jump
+ * straight into the handlers of the next table.
+ ***************************************************************/
+#if Z80_THREADED
+#ifdef Z80_PROFILE
+#define THREAD_PROFILE_START	icount = Z80_ICOUNT
+#define THREAD_PROFILE_END		{ if( z80_profile_insn ) (*z80_profile_insn)(_PPC, icount - Z80_ICOUNT); }
+#else
+#define THREAD_PROFILE_START
+#define THREAD_PROFILE_END
+#endif
+
+#define THREAD_DISPATCH(prefix,opcode)							\
+{																\
+	unsigned op = opcode;										\
+	CC(prefix,op);												\
+	PROFILE_OP(prefix,op);										\
+	goto *prefix##_label[op];									\
+}
+
+#define THREAD_FETCH 											\
+{																\
+	THREAD_PROFILE_START;										\
+	TRACK_PPC;													\
+	_R++;														\
+	THREAD_DISPATCH(op,ROP());									\
+}
+
+#define THREAD_NEXT 											\
+{																\
+	THREAD_PROFILE_END; 										\
+	if( Z80_ICOUNT <= 0 ) goto thread_done; 					\
+	THREAD_FETCH;												\
+}
+
+#define THREAD_LABELS(prefix)                               \
+	&&prefix##_##00##_L, &&prefix##_##01##_L, &&prefix##_##02##_L, &&prefix##_##03##_L, &&prefix##_##04##_L, &&prefix##_##05##_L, &&prefix##_##06##_L, &&prefix##_##07##_L, \
+	&&prefix##_##08##_L, &&prefix##_##09##_L, &&prefix##_##0a##_L, &&prefix##_##0b##_L, &&prefix##_##0c##_L, &&prefix##_##0d##_L, &&prefix##_##0e##_L, &&prefix##_##0f##_L, \
+	&&prefix##_##10##_L, &&prefix##_##11##_L, &&prefix##_##12##_L, &&prefix##_##13##_L, &&prefix##_##14##_L, &&prefix##_##15##_L, &&prefix##_##16##_L, &&prefix##_##17##_L, \
+	&&prefix##_##18##_L, &&prefix##_##19##_L, &&prefix##_##1a##_L, &&prefix##_##1b##_L, &&prefix##_##1c##_L, &&prefix##_##1d##_L, &&prefix##_##1e##_L, &&prefix##_##1f##_L, \
+	&&prefix##_##20##_L, &&prefix##_##21##_L, &&prefix##_##22##_L, &&prefix##_##23##_L, &&prefix##_##24##_L, &&prefix##_##25##_L, &&prefix##_##26##_L, &&prefix##_##27##_L, \
+	&&prefix##_##28##_L, &&prefix##_##29##_L, &&prefix##_##2a##_L, &&prefix##_##2b##_L, &&prefix##_##2c##_L, &&prefix##_##2d##_L, &&prefix##_##2e##_L, &&prefix##_##2f##_L, \
+	&&prefix##_##30##_L, &&prefix##_##31##_L, &&prefix##_##32##_L, &&prefix##_##33##_L, &&prefix##_##34##_L, &&prefix##_##35##_L, &&prefix##_##36##_L, &&prefix##_##37##_L, \
+	&&prefix##_##38##_L, &&prefix##_##39##_L, &&prefix##_##3a##_L, &&prefix##_##3b##_L, &&prefix##_##3c##_L, &&prefix##_##3d##_L, &&prefix##_##3e##_L, &&prefix##_##3f##_L, \
+	&&prefix##_##40##_L, &&prefix##_##41##_L, &&prefix##_##42##_L, &&prefix##_##43##_L, &&prefix##_##44##_L, &&prefix##_##45##_L, &&prefix##_##46##_L, &&prefix##_##47##_L, \
+	&&prefix##_##48##_L, &&prefix##_##49##_L, &&prefix##_##4a##_L, &&prefix##_##4b##_L, &&prefix##_##4c##_L, &&prefix##_##4d##_L, &&prefix##_##4e##_L, &&prefix##_##4f##_L, \
+	&&prefix##_##50##_L, &&prefix##_##51##_L, &&prefix##_##52##_L, &&prefix##_##53##_L, &&prefix##_##54##_L, &&prefix##_##55##_L, &&prefix##_##56##_L, &&prefix##_##57##_L, \
+	&&prefix##_##58##_L, &&prefix##_##59##_L, &&prefix##_##5a##_L, &&prefix##_##5b##_L, &&prefix##_##5c##_L, &&prefix##_##5d##_L, &&prefix##_##5e##_L, &&prefix##_##5f##_L, \
+	&&prefix##_##60##_L, &&prefix##_##61##_L, &&prefix##_##62##_L, &&prefix##_##63##_L, &&prefix##_##64##_L, &&prefix##_##65##_L, &&prefix##_##66##_L, &&prefix##_##67##_L, \
+	&&prefix##_##68##_L, &&prefix##_##69##_L, &&prefix##_##6a##_L, &&prefix##_##6b##_L, &&prefix##_##6c##_L, &&prefix##_##6d##_L, &&prefix##_##6e##_L, &&prefix##_##6f##_L, \
+	&&prefix##_##70##_L, &&prefix##_##71##_L, &&prefix##_##72##_L, &&prefix##_##73##_L, &&prefix##_##74##_L, &&prefix##_##75##_L, &&prefix##_##76##_L, &&prefix##_##77##_L, \
+	&&prefix##_##78##_L, &&prefix##_##79##_L, &&prefix##_##7a##_L, &&prefix##_##7b##_L, &&prefix##_##7c##_L, &&prefix##_##7d##_L, &&prefix##_##7e##_L, &&prefix##_##7f##_L, \
+	&&prefix##_##80##_L, &&prefix##_##81##_L, &&prefix##_##82##_L, &&prefix##_##83##_L, &&prefix##_##84##_L, &&prefix##_##85##_L, &&prefix##_##86##_L, &&prefix##_##87##_L, \
+	&&prefix##_##88##_L, &&prefix##_##89##_L, &&prefix##_##8a##_L, &&prefix##_##8b##_L, &&prefix##_##8c##_L, &&prefix##_##8d##_L, &&prefix##_##8e##_L, &&prefix##_##8f##_L, \
+	&&prefix##_##90##_L, &&prefix##_##91##_L, &&prefix##_##92##_L, &&prefix##_##93##_L, &&prefix##_##94##_L, &&prefix##_##95##_L, &&prefix##_##96##_L, &&prefix##_##97##_L, \
+	&&prefix##_##98##_L, &&prefix##_##99##_L, &&prefix##_##9a##_L, &&prefix##_##9b##_L, &&prefix##_##9c##_L, &&prefix##_##9d##_L, &&prefix##_##9e##_L, &&prefix##_##9f##_L, \
+	&&prefix##_##a0##_L, &&prefix##_##a1##_L, &&prefix##_##a2##_L, &&prefix##_##a3##_L, &&prefix##_##a4##_L, &&prefix##_##a5##_L, &&prefix##_##a6##_L, &&prefix##_##a7##_L, \
+	&&prefix##_##a8##_L, &&prefix##_##a9##_L, &&prefix##_##aa##_L, &&prefix##_##ab##_L, &&prefix##_##ac##_L, &&prefix##_##ad##_L, &&prefix##_##ae##_L, &&prefix##_##af##_L, \
+	&&prefix##_##b0##_L, &&prefix##_##b1##_L, &&prefix##_##b2##_L, &&prefix##_##b3##_L, &&prefix##_##b4##_L, &&prefix##_##b5##_L, &&prefix##_##b6##_L, &&prefix##_##b7##_L, \
+	&&prefix##_##b8##_L, &&prefix##_##b9##_L, &&prefix##_##ba##_L, &&prefix##_##bb##_L, &&prefix##_##bc##_L, &&prefix##_##bd##_L, &&prefix##_##be##_L, &&prefix##_##bf##_L, \
+	&&prefix##_##c0##_L, &&prefix##_##c1##_L, &&prefix##_##c2##_L, &&prefix##_##c3##_L, &&prefix##_##c4##_L, &&prefix##_##c5##_L, &&prefix##_##c6##_L, &&prefix##_##c7##_L, \
+	&&prefix##_##c8##_L, &&prefix##_##c9##_L, &&prefix##_##ca##_L, &&prefix##_##cb##_L, &&prefix##_##cc##_L, &&prefix##_##cd##_L, &&prefix##_##ce##_L, &&prefix##_##cf##_L, \
+	&&prefix##_##d0##_L, &&prefix##_##d1##_L, &&prefix##_##d2##_L, &&prefix##_##d3##_L, &&prefix##_##d4##_L, &&prefix##_##d5##_L, &&prefix##_##d6##_L, &&prefix##_##d7##_L, \
+	&&prefix##_##d8##_L, &&prefix##_##d9##_L, &&prefix##_##da##_L, &&prefix##_##db##_L, &&prefix##_##dc##_L, &&prefix##_##dd##_L, &&prefix##_##de##_L, &&prefix##_##df##_L, \
+	&&prefix##_##e0##_L, &&prefix##_##e1##_L, &&prefix##_##e2##_L, &&prefix##_##e3##_L, &&prefix##_##e4##_L, &&prefix##_##e5##_L, &&prefix##_##e6##_L, &&prefix##_##e7##_L, \
+	&&prefix##_##e8##_L, &&prefix##_##e9##_L, &&prefix##_##ea##_L, &&prefix##_##eb##_L, &&prefix##_##ec##_L, &&prefix##_##ed##_L, &&prefix##_##ee##_L, &&prefix##_##ef##_L, \
+	&&prefix##_##f0##_L, &&prefix##_##f1##_L, &&prefix##_##f2##_L, &&prefix##_##f3##_L, &&prefix##_##f4##_L, &&prefix##_##f5##_L, &&prefix##_##f6##_L, &&prefix##_##f7##_L, \
+	&&prefix##_##f8##_L, &&prefix##_##f9##_L, &&prefix##_##fa##_L, &&prefix##_##fb##_L, &&prefix##_##fc##_L, &&prefix##_##fd##_L, &&prefix##_##fe##_L, &&prefix##_##ff##_L,
+
+/* all opcodes, used for the CB, ED and xycb tables */
+#define THREAD_HANDLERS(prefix)                             \
+	prefix##_##00##_L: prefix##_##00(); THREAD_NEXT; prefix##_##01##_L: prefix##_##01(); THREAD_NEXT; prefix##_##02##_L: prefix##_##02(); THREAD_NEXT; prefix##_##03##_L: prefix##_##03(); THREAD_NEXT; \
+	prefix##_##04##_L: prefix##_##04(); THREAD_NEXT; prefix##_##05##_L: prefix##_##05(); THREAD_NEXT; prefix##_##06##_L: prefix##_##06(); THREAD_NEXT; prefix##_##07##_L: prefix##_##07(); THREAD_NEXT; \
+	prefix##_##08##_L: prefix##_##08(); THREAD_NEXT; prefix##_##09##_L: prefix##_##09(); THREAD_NEXT; prefix##_##0a##_L: prefix##_##0a(); THREAD_NEXT; prefix##_##0b##_L: prefix##_##0b(); THREAD_NEXT; \
+	prefix##_##0c##_L: prefix##_##0c(); THREAD_NEXT; prefix##_##0d##_L: prefix##_##0d(); THREAD_NEXT; prefix##_##0e##_L: prefix##_##0e(); THREAD_NEXT; prefix##_##0f##_L: prefix##_##0f(); THREAD_NEXT; \
+	prefix##_##10##_L: prefix##_##10(); THREAD_NEXT; prefix##_##11##_L: prefix##_##11(); THREAD_NEXT; prefix##_##12##_L: prefix##_##12(); THREAD_NEXT; prefix##_##13##_L: prefix##_##13(); THREAD_NEXT; \
+	prefix##_##14##_L: prefix##_##14(); THREAD_NEXT; prefix##_##15##_L: prefix##_##15(); THREAD_NEXT; prefix##_##16##_L: prefix##_##16(); THREAD_NEXT; prefix##_##17##_L: prefix##_##17(); THREAD_NEXT; \
+	prefix##_##18##_L: prefix##_##18(); THREAD_NEXT; prefix##_##19##_L: prefix##_##19(); THREAD_NEXT; prefix##_##1a##_L: prefix##_##1a(); THREAD_NEXT; prefix##_##1b##_L: prefix##_##1b(); THREAD_NEXT; \
+	prefix##_##1c##_L: prefix##_##1c(); THREAD_NEXT; prefix##_##1d##_L: prefix##_##1d(); THREAD_NEXT; prefix##_##1e##_L: prefix##_##1e(); THREAD_NEXT; prefix##_##1f##_L: prefix##_##1f(); THREAD_NEXT; \
+	prefix##_##20##_L: prefix##_##20(); THREAD_NEXT; prefix##_##21##_L: prefix##_##21(); THREAD_NEXT; prefix##_##22##_L: prefix##_##22(); THREAD_NEXT; prefix##_##23##_L: prefix##_##23(); THREAD_NEXT; \
+	prefix##_##24##_L: prefix##_##24(); THREAD_NEXT; prefix##_##25##_L: prefix##_##25(); THREAD_NEXT; prefix##_##26##_L: prefix##_##26(); THREAD_NEXT; prefix##_##27##_L: prefix##_##27(); THREAD_NEXT; \
+	prefix##_##28##_L: prefix##_##28(); THREAD_NEXT; prefix##_##29##_L: prefix##_##29(); THREAD_NEXT; prefix##_##2a##_L: prefix##_##2a(); THREAD_NEXT; prefix##_##2b##_L: prefix##_##2b(); THREAD_NEXT; \
+	prefix##_##2c##_L: prefix##_##2c(); THREAD_NEXT; prefix##_##2d##_L: prefix##_##2d(); THREAD_NEXT; prefix##_##2e##_L: prefix##_##2e(); THREAD_NEXT; prefix##_##2f##_L: prefix##_##2f(); THREAD_NEXT; \
+	prefix##_##30##_L: prefix##_##30(); THREAD_NEXT; prefix##_##31##_L: prefix##_##31(); THREAD_NEXT; prefix##_##32##_L: prefix##_##32(); THREAD_NEXT; prefix##_##33##_L: prefix##_##33(); THREAD_NEXT; \
+	prefix##_##34##_L: prefix##_##34(); THREAD_NEXT; prefix##_##35##_L: prefix##_##35(); THREAD_NEXT; prefix##_##36##_L: prefix##_##36(); THREAD_NEXT; prefix##_##37##_L: prefix##_##37(); THREAD_NEXT; \
+	prefix##_##38##_L: prefix##_##38(); THREAD_NEXT; prefix##_##39##_L: prefix##_##39(); THREAD_NEXT; prefix##_##3a##_L: prefix##_##3a(); THREAD_NEXT; prefix##_##3b##_L: prefix##_##3b(); THREAD_NEXT; \
+	prefix##_##3c##_L: prefix##_##3c(); THREAD_NEXT; prefix##_##3d##_L: prefix##_##3d(); THREAD_NEXT; prefix##_##3e##_L: prefix##_##3e(); THREAD_NEXT; prefix##_##3f##_L: prefix##_##3f(); THREAD_NEXT; \
+	prefix##_##40##_L: prefix##_##40(); THREAD_NEXT; prefix##_##41##_L: prefix##_##41(); THREAD_NEXT; prefix##_##42##_L: prefix##_##42(); THREAD_NEXT; prefix##_##43##_L: prefix##_##43(); THREAD_NEXT; \
+	prefix##_##44##_L: prefix##_##44(); THREAD_NEXT; prefix##_##45##_L: prefix##_##45(); THREAD_NEXT; prefix##_##46##_L: prefix##_##46(); THREAD_NEXT; prefix##_##47##_L: prefix##_##47(); THREAD_NEXT; \
+	prefix##_##48##_L: prefix##_##48(); THREAD_NEXT; prefix##_##49##_L: prefix##_##49(); THREAD_NEXT; prefix##_##4a##_L: prefix##_##4a(); THREAD_NEXT; prefix##_##4b##_L: prefix##_##4b(); THREAD_NEXT; \
+	prefix##_##4c##_L: prefix##_##4c(); THREAD_NEXT; prefix##_##4d##_L: prefix##_##4d(); THREAD_NEXT; prefix##_##4e##_L: prefix##_##4e(); THREAD_NEXT; prefix##_##4f##_L: prefix##_##4f(); THREAD_NEXT; \
+	prefix##_##50##_L: prefix##_##50(); THREAD_NEXT; prefix##_##51##_L: prefix##_##51(); THREAD_NEXT; prefix##_##52##_L: prefix##_##52(); THREAD_NEXT; prefix##_##53##_L: prefix##_##53(); THREAD_NEXT; \
+	prefix##_##54##_L: prefix##_##54(); THREAD_NEXT; prefix##_##55##_L: prefix##_##55(); THREAD_NEXT; prefix##_##56##_L: prefix##_##56(); THREAD_NEXT; prefix##_##57##_L: prefix##_##57(); THREAD_NEXT; \
+	prefix##_##58##_L: prefix##_##58(); THREAD_NEXT; prefix##_##59##_L: prefix##_##59(); THREAD_NEXT; prefix##_##5a##_L: prefix##_##5a(); THREAD_NEXT; prefix##_##5b##_L: prefix##_##5b(); THREAD_NEXT; \
+	prefix##_##5c##_L: prefix##_##5c(); THREAD_NEXT; prefix##_##5d##_L: prefix##_##5d(); THREAD_NEXT; prefix##_##5e##_L: prefix##_##5e(); THREAD_NEXT; prefix##_##5f##_L: prefix##_##5f(); THREAD_NEXT; \
+	prefix##_##60##_L: prefix##_##60(); THREAD_NEXT; prefix##_##61##_L: prefix##_##61(); THREAD_NEXT; prefix##_##62##_L: prefix##_##62(); THREAD_NEXT; prefix##_##63##_L: prefix##_##63(); THREAD_NEXT; \
+	prefix##_##64##_L: prefix##_##64(); THREAD_NEXT; prefix##_##65##_L: prefix##_##65(); THREAD_NEXT; prefix##_##66##_L: prefix##_##66(); THREAD_NEXT; prefix##_##67##_L: prefix##_##67(); THREAD_NEXT; \
+	prefix##_##68##_L: prefix##_##68(); THREAD_NEXT; prefix##_##69##_L: prefix##_##69(); THREAD_NEXT; prefix##_##6a##_L: prefix##_##6a(); THREAD_NEXT; prefix##_##6b##_L: prefix##_##6b(); THREAD_NEXT; \
+	prefix##_##6c##_L: prefix##_##6c(); THREAD_NEXT; prefix##_##6d##_L: prefix##_##6d(); THREAD_NEXT; prefix##_##6e##_L: prefix##_##6e(); THREAD_NEXT; prefix##_##6f##_L: prefix##_##6f(); THREAD_NEXT; \
+	prefix##_##70##_L: prefix##_##70(); THREAD_NEXT; prefix##_##71##_L: prefix##_##71(); THREAD_NEXT; prefix##_##72##_L: prefix##_##72(); THREAD_NEXT; prefix##_##73##_L: prefix##_##73(); THREAD_NEXT; \
+	prefix##_##74##_L: prefix##_##74(); THREAD_NEXT; prefix##_##75##_L: prefix##_##75(); THREAD_NEXT; prefix##_##76##_L: prefix##_##76(); THREAD_NEXT; prefix##_##77##_L: prefix##_##77(); THREAD_NEXT; \
+	prefix##_##78##_L: prefix##_##78(); THREAD_NEXT; prefix##_##79##_L: prefix##_##79(); THREAD_NEXT; prefix##_##7a##_L: prefix##_##7a(); THREAD_NEXT; prefix##_##7b##_L: prefix##_##7b(); THREAD_NEXT; \
+	prefix##_##7c##_L: prefix##_##7c(); THREAD_NEXT; prefix##_##7d##_L: prefix##_##7d(); THREAD_NEXT; prefix##_##7e##_L: prefix##_##7e(); THREAD_NEXT; prefix##_##7f##_L: prefix##_##7f(); THREAD_NEXT; \
+	prefix##_##80##_L: prefix##_##80(); THREAD_NEXT; prefix##_##81##_L: prefix##_##81(); THREAD_NEXT; prefix##_##82##_L: prefix##_##82(); THREAD_NEXT; prefix##_##83##_L: prefix##_##83(); THREAD_NEXT; \
+	prefix##_##84##_L: prefix##_##84(); THREAD_NEXT; prefix##_##85##_L: prefix##_##85(); THREAD_NEXT; prefix##_##86##_L: prefix##_##86(); THREAD_NEXT; prefix##_##87##_L: prefix##_##87(); THREAD_NEXT; \
+	prefix##_##88##_L: prefix##_##88(); THREAD_NEXT; prefix##_##89##_L: prefix##_##89(); THREAD_NEXT; prefix##_##8a##_L: prefix##_##8a(); THREAD_NEXT; prefix##_##8b##_L: prefix##_##8b(); THREAD_NEXT; \
+	prefix##_##8c##_L: prefix##_##8c(); THREAD_NEXT; prefix##_##8d##_L: prefix##_##8d(); THREAD_NEXT; prefix##_##8e##_L: prefix##_##8e(); THREAD_NEXT; prefix##_##8f##_L: prefix##_##8f(); THREAD_NEXT; \
+	prefix##_##90##_L: prefix##_##90(); THREAD_NEXT; prefix##_##91##_L: prefix##_##91(); THREAD_NEXT; prefix##_##92##_L: prefix##_##92(); THREAD_NEXT; prefix##_##93##_L: prefix##_##93(); THREAD_NEXT; \
+	prefix##_##94##_L: prefix##_##94(); THREAD_NEXT; prefix##_##95##_L: prefix##_##95(); THREAD_NEXT; prefix##_##96##_L: prefix##_##96(); THREAD_NEXT; prefix##_##97##_L: prefix##_##97(); THREAD_NEXT; \
+	prefix##_##98##_L: prefix##_##98(); THREAD_NEXT; prefix##_##99##_L: prefix##_##99(); THREAD_NEXT; prefix##_##9a##_L: prefix##_##9a(); THREAD_NEXT; prefix##_##9b##_L: prefix##_##9b(); THREAD_NEXT; \
+	prefix##_##9c##_L: prefix##_##9c(); THREAD_NEXT; prefix##_##9d##_L: prefix##_##9d(); THREAD_NEXT; prefix##_##9e##_L: prefix##_##9e(); THREAD_NEXT; prefix##_##9f##_L: prefix##_##9f(); THREAD_NEXT; \
+	prefix##_##a0##_L: prefix##_##a0(); THREAD_NEXT; prefix##_##a1##_L: prefix##_##a1(); THREAD_NEXT; prefix##_##a2##_L: prefix##_##a2(); THREAD_NEXT; prefix##_##a3##_L: prefix##_##a3(); THREAD_NEXT; \
+	prefix##_##a4##_L: prefix##_##a4(); THREAD_NEXT; prefix##_##a5##_L: prefix##_##a5(); THREAD_NEXT; prefix##_##a6##_L: prefix##_##a6(); THREAD_NEXT; prefix##_##a7##_L: prefix##_##a7(); THREAD_NEXT; \
+	prefix##_##a8##_L: prefix##_##a8(); THREAD_NEXT; prefix##_##a9##_L: prefix##_##a9(); THREAD_NEXT; prefix##_##aa##_L: prefix##_##aa(); THREAD_NEXT; prefix##_##ab##_L: prefix##_##ab(); THREAD_NEXT; \
+	prefix##_##ac##_L: prefix##_##ac(); THREAD_NEXT; prefix##_##ad##_L: prefix##_##ad(); THREAD_NEXT; prefix##_##ae##_L: prefix##_##ae(); THREAD_NEXT; prefix##_##af##_L: prefix##_##af(); THREAD_NEXT; \
+	prefix##_##b0##_L: prefix##_##b0(); THREAD_NEXT; prefix##_##b1##_L: prefix##_##b1(); THREAD_NEXT; prefix##_##b2##_L: prefix##_##b2(); THREAD_NEXT; prefix##_##b3##_L: prefix##_##b3(); THREAD_NEXT; \
+	prefix##_##b4##_L: prefix##_##b4(); THREAD_NEXT; prefix##_##b5##_L: prefix##_##b5(); THREAD_NEXT; prefix##_##b6##_L: prefix##_##b6(); THREAD_NEXT; prefix##_##b7##_L: prefix##_##b7(); THREAD_NEXT; \
+	prefix##_##b8##_L: prefix##_##b8(); THREAD_NEXT; prefix##_##b9##_L: prefix##_##b9(); THREAD_NEXT; prefix##_##ba##_L: prefix##_##ba(); THREAD_NEXT; prefix##_##bb##_L: prefix##_##bb(); THREAD_NEXT; \
+	prefix##_##bc##_L: prefix##_##bc(); THREAD_NEXT; prefix##_##bd##_L: prefix##_##bd(); THREAD_NEXT; prefix##_##be##_L: prefix##_##be(); THREAD_NEXT; prefix##_##bf##_L: prefix##_##bf(); THREAD_NEXT; \
+	prefix##_##c0##_L: prefix##_##c0(); THREAD_NEXT; prefix##_##c1##_L: prefix##_##c1(); THREAD_NEXT; prefix##_##c2##_L: prefix##_##c2(); THREAD_NEXT; prefix##_##c3##_L: prefix##_##c3(); THREAD_NEXT; \
+	prefix##_##c4##_L: prefix##_##c4(); THREAD_NEXT; prefix##_##c5##_L: prefix##_##c5(); THREAD_NEXT; prefix##_##c6##_L: prefix##_##c6(); THREAD_NEXT; prefix##_##c7##_L: prefix##_##c7(); THREAD_NEXT; \
+	prefix##_##c8##_L: prefix##_##c8(); THREAD_NEXT; prefix##_##c9##_L: prefix##_##c9(); THREAD_NEXT; prefix##_##ca##_L: prefix##_##ca(); THREAD_NEXT; prefix##_##cb##_L: prefix##_##cb(); THREAD_NEXT; \
+	prefix##_##cc##_L: prefix##_##cc(); THREAD_NEXT; prefix##_##cd##_L: prefix##_##cd(); THREAD_NEXT; prefix##_##ce##_L: prefix##_##ce(); THREAD_NEXT; prefix##_##cf##_L: prefix##_##cf(); THREAD_NEXT; \
+	prefix##_##d0##_L: prefix##_##d0(); THREAD_NEXT; prefix##_##d1##_L: prefix##_##d1(); THREAD_NEXT; prefix##_##d2##_L: prefix##_##d2(); THREAD_NEXT; prefix##_##d3##_L: prefix##_##d3(); THREAD_NEXT; \
+	prefix##_##d4##_L: prefix##_##d4(); THREAD_NEXT; prefix##_##d5##_L: prefix##_##d5(); THREAD_NEXT; prefix##_##d6##_L: prefix##_##d6(); THREAD_NEXT; prefix##_##d7##_L: prefix##_##d7(); THREAD_NEXT; \
+	prefix##_##d8##_L: prefix##_##d8(); THREAD_NEXT; prefix##_##d9##_L: prefix##_##d9(); THREAD_NEXT; prefix##_##da##_L: prefix##_##da(); THREAD_NEXT; prefix##_##db##_L: prefix##_##db(); THREAD_NEXT; \
+	prefix##_##dc##_L: prefix##_##dc(); THREAD_NEXT; prefix##_##dd##_L: prefix##_##dd(); THREAD_NEXT; prefix##_##de##_L: prefix##_##de(); THREAD_NEXT; prefix##_##df##_L: prefix##_##df(); THREAD_NEXT; \
+	prefix##_##e0##_L: prefix##_##e0(); THREAD_NEXT; prefix##_##e1##_L: prefix##_##e1(); THREAD_NEXT; prefix##_##e2##_L: prefix##_##e2(); THREAD_NEXT; prefix##_##e3##_L: prefix##_##e3(); THREAD_NEXT; \
+	prefix##_##e4##_L: prefix##_##e4(); THREAD_NEXT; prefix##_##e5##_L: prefix##_##e5(); THREAD_NEXT; prefix##_##e6##_L: prefix##_##e6(); THREAD_NEXT; prefix##_##e7##_L: prefix##_##e7(); THREAD_NEXT; \
+	prefix##_##e8##_L: prefix##_##e8(); THREAD_NEXT; prefix##_##e9##_L: prefix##_##e9(); THREAD_NEXT; prefix##_##ea##_L: prefix##_##ea(); THREAD_NEXT; prefix##_##eb##_L: prefix##_##eb(); THREAD_NEXT; \
+	prefix##_##ec##_L: prefix##_##ec(); THREAD_NEXT; prefix##_##ed##_L: prefix##_##ed(); THREAD_NEXT; prefix##_##ee##_L: prefix##_##ee(); THREAD_NEXT; prefix##_##ef##_L: prefix##_##ef(); THREAD_NEXT; \
+	prefix##_##f0##_L: prefix##_##f0(); THREAD_NEXT; prefix##_##f1##_L: prefix##_##f1(); THREAD_NEXT; prefix##_##f2##_L: prefix##_##f2(); THREAD_NEXT; prefix##_##f3##_L: prefix##_##f3(); THREAD_NEXT; \
+	prefix##_##f4##_L: prefix##_##f4(); THREAD_NEXT; prefix##_##f5##_L: prefix##_##f5(); THREAD_NEXT; prefix##_##f6##_L: prefix##_##f6(); THREAD_NEXT; prefix##_##f7##_L: prefix##_##f7(); THREAD_NEXT; \
+	prefix##_##f8##_L: prefix##_##f8(); THREAD_NEXT; prefix##_##f9##_L: prefix##_##f9(); THREAD_NEXT; prefix##_##fa##_L: prefix##_##fa(); THREAD_NEXT; prefix##_##fb##_L: prefix##_##fb(); THREAD_NEXT; \
+	prefix##_##fc##_L: prefix##_##fc(); THREAD_NEXT; prefix##_##fd##_L: prefix##_##fd(); THREAD_NEXT; prefix##_##fe##_L: prefix##_##fe(); THREAD_NEXT; prefix##_##ff##_L: prefix##_##ff(); THREAD_NEXT;
+
+/* DD and FD tables, the xycb prefix is threaded */
+#define THREAD_HANDLERS_XY(prefix)                          \
+	prefix##_##00##_L: prefix##_##00(); THREAD_NEXT; prefix##_##01##_L: prefix##_##01(); THREAD_NEXT; prefix##_##02##_L: prefix##_##02(); THREAD_NEXT; prefix##_##03##_L: prefix##_##03(); THREAD_NEXT; \
+	prefix##_##04##_L: prefix##_##04(); THREAD_NEXT; prefix##_##05##_L: prefix##_##05(); THREAD_NEXT; prefix##_##06##_L: prefix##_##06(); THREAD_NEXT; prefix##_##07##_L: prefix##_##07(); THREAD_NEXT; \
+	prefix##_##08##_L: prefix##_##08(); THREAD_NEXT; prefix##_##09##_L: prefix##_##09(); THREAD_NEXT; prefix##_##0a##_L: prefix##_##0a(); THREAD_NEXT; prefix##_##0b##_L: prefix##_##0b(); THREAD_NEXT; \
+	prefix##_##0c##_L: prefix##_##0c(); THREAD_NEXT; prefix##_##0d##_L: prefix##_##0d(); THREAD_NEXT; prefix##_##0e##_L: prefix##_##0e(); THREAD_NEXT; prefix##_##0f##_L: prefix##_##0f(); THREAD_NEXT; \
+	prefix##_##10##_L: prefix##_##10(); THREAD_NEXT; prefix##_##11##_L: prefix##_##11(); THREAD_NEXT; prefix##_##12##_L: prefix##_##12(); THREAD_NEXT; prefix##_##13##_L: prefix##_##13(); THREAD_NEXT; \
+	prefix##_##14##_L: prefix##_##14(); THREAD_NEXT; prefix##_##15##_L: prefix##_##15(); THREAD_NEXT; prefix##_##16##_L: prefix##_##16(); THREAD_NEXT; prefix##_##17##_L: prefix##_##17(); THREAD_NEXT; \
+	prefix##_##18##_L: prefix##_##18(); THREAD_NEXT; prefix##_##19##_L: prefix##_##19(); THREAD_NEXT; prefix##_##1a##_L: prefix##_##1a(); THREAD_NEXT; prefix##_##1b##_L: prefix##_##1b(); THREAD_NEXT; \
+	prefix##_##1c##_L: prefix##_##1c(); THREAD_NEXT; prefix##_##1d##_L: prefix##_##1d(); THREAD_NEXT; prefix##_##1e##_L: prefix##_##1e(); THREAD_NEXT; prefix##_##1f##_L: prefix##_##1f(); THREAD_NEXT; \
+	prefix##_##20##_L: prefix##_##20(); THREAD_NEXT; prefix##_##21##_L: prefix##_##21(); THREAD_NEXT; prefix##_##22##_L: prefix##_##22(); THREAD_NEXT; prefix##_##23##_L: prefix##_##23(); THREAD_NEXT; \
+	prefix##_##24##_L: prefix##_##24(); THREAD_NEXT; prefix##_##25##_L: prefix##_##25(); THREAD_NEXT; prefix##_##26##_L: prefix##_##26(); THREAD_NEXT; prefix##_##27##_L: prefix##_##27(); THREAD_NEXT; \
+	prefix##_##28##_L: prefix##_##28(); THREAD_NEXT; prefix##_##29##_L: prefix##_##29(); THREAD_NEXT; prefix##_##2a##_L: prefix##_##2a(); THREAD_NEXT; prefix##_##2b##_L: prefix##_##2b(); THREAD_NEXT; \
+	prefix##_##2c##_L: prefix##_##2c(); THREAD_NEXT; prefix##_##2d##_L: prefix##_##2d(); THREAD_NEXT; prefix##_##2e##_L: prefix##_##2e(); THREAD_NEXT; prefix##_##2f##_L: prefix##_##2f(); THREAD_NEXT; \
+	prefix##_##30##_L: prefix##_##30(); THREAD_NEXT; prefix##_##31##_L: prefix##_##31(); THREAD_NEXT; prefix##_##32##_L: prefix##_##32(); THREAD_NEXT; prefix##_##33##_L: prefix##_##33(); THREAD_NEXT; \
+	prefix##_##34##_L: prefix##_##34(); THREAD_NEXT; prefix##_##35##_L: prefix##_##35(); THREAD_NEXT; prefix##_##36##_L: prefix##_##36(); THREAD_NEXT; prefix##_##37##_L: prefix##_##37(); THREAD_NEXT; \
+	prefix##_##38##_L: prefix##_##38(); THREAD_NEXT; prefix##_##39##_L: prefix##_##39(); THREAD_NEXT; prefix##_##3a##_L: prefix##_##3a(); THREAD_NEXT; prefix##_##3b##_L: prefix##_##3b(); THREAD_NEXT; \
+	prefix##_##3c##_L: prefix##_##3c(); THREAD_NEXT; prefix##_##3d##_L: prefix##_##3d(); THREAD_NEXT; prefix##_##3e##_L: prefix##_##3e(); THREAD_NEXT; prefix##_##3f##_L: prefix##_##3f(); THREAD_NEXT; \
+	prefix##_##40##_L: prefix##_##40(); THREAD_NEXT; prefix##_##41##_L: prefix##_##41(); THREAD_NEXT; prefix##_##42##_L: prefix##_##42(); THREAD_NEXT; prefix##_##43##_L: prefix##_##43(); THREAD_NEXT; \
+	prefix##_##44##_L: prefix##_##44(); THREAD_NEXT; prefix##_##45##_L: prefix##_##45(); THREAD_NEXT; prefix##_##46##_L: prefix##_##46(); THREAD_NEXT; prefix##_##47##_L: prefix##_##47(); THREAD_NEXT; \
+	prefix##_##48##_L: prefix##_##48(); THREAD_NEXT; prefix##_##49##_L: prefix##_##49(); THREAD_NEXT; prefix##_##4a##_L: prefix##_##4a(); THREAD_NEXT; prefix##_##4b##_L: prefix##_##4b(); THREAD_NEXT; \
+	prefix##_##4c##_L: prefix##_##4c(); THREAD_NEXT; prefix##_##4d##_L: prefix##_##4d(); THREAD_NEXT; prefix##_##4e##_L: prefix##_##4e(); THREAD_NEXT; prefix##_##4f##_L: prefix##_##4f(); THREAD_NEXT; \
+	prefix##_##50##_L: prefix##_##50(); THREAD_NEXT; prefix##_##51##_L: prefix##_##51(); THREAD_NEXT; prefix##_##52##_L: prefix##_##52(); THREAD_NEXT; prefix##_##53##_L: prefix##_##53(); THREAD_NEXT; \
+	prefix##_##54##_L: prefix##_##54(); THREAD_NEXT; prefix##_##55##_L: prefix##_##55(); THREAD_NEXT; prefix##_##56##_L: prefix##_##56(); THREAD_NEXT; prefix##_##57##_L: prefix##_##57(); THREAD_NEXT; \
+	prefix##_##58##_L: prefix##_##58(); THREAD_NEXT; prefix##_##59##_L: prefix##_##59(); THREAD_NEXT; prefix##_##5a##_L: prefix##_##5a(); THREAD_NEXT; prefix##_##5b##_L: prefix##_##5b(); THREAD_NEXT; \
+	prefix##_##5c##_L: prefix##_##5c(); THREAD_NEXT; prefix##_##5d##_L: prefix##_##5d(); THREAD_NEXT; prefix##_##5e##_L: prefix##_##5e(); THREAD_NEXT; prefix##_##5f##_L: prefix##_##5f(); THREAD_NEXT; \
+	prefix##_##60##_L: prefix##_##60(); THREAD_NEXT; prefix##_##61##_L: prefix##_##61(); THREAD_NEXT; prefix##_##62##_L: prefix##_##62(); THREAD_NEXT; prefix##_##63##_L: prefix##_##63(); THREAD_NEXT; \
+	prefix##_##64##_L: prefix##_##64(); THREAD_NEXT; prefix##_##65##_L: prefix##_##65(); THREAD_NEXT; prefix##_##66##_L: prefix##_##66(); THREAD_NEXT; prefix##_##67##_L: prefix##_##67(); THREAD_NEXT; \
+	prefix##_##68##_L: prefix##_##68(); THREAD_NEXT; prefix##_##69##_L: prefix##_##69(); THREAD_NEXT; prefix##_##6a##_L: prefix##_##6a(); THREAD_NEXT; prefix##_##6b##_L: prefix##_##6b(); THREAD_NEXT; \
+	prefix##_##6c##_L: prefix##_##6c(); THREAD_NEXT; prefix##_##6d##_L: prefix##_##6d(); THREAD_NEXT; prefix##_##6e##_L: prefix##_##6e(); THREAD_NEXT; prefix##_##6f##_L: prefix##_##6f(); THREAD_NEXT; \
+	prefix##_##70##_L: prefix##_##70(); THREAD_NEXT; prefix##_##71##_L: prefix##_##71(); THREAD_NEXT; prefix##_##72##_L: prefix##_##72(); THREAD_NEXT; prefix##_##73##_L: prefix##_##73(); THREAD_NEXT; \
+	prefix##_##74##_L: prefix##_##74(); THREAD_NEXT; prefix##_##75##_L: prefix##_##75(); THREAD_NEXT; prefix##_##76##_L: prefix##_##76(); THREAD_NEXT; prefix##_##77##_L: prefix##_##77(); THREAD_NEXT; \
+	prefix##_##78##_L: prefix##_##78(); THREAD_NEXT; prefix##_##79##_L: prefix##_##79(); THREAD_NEXT; prefix##_##7a##_L: prefix##_##7a(); THREAD_NEXT; prefix##_##7b##_L: prefix##_##7b(); THREAD_NEXT; \
+	prefix##_##7c##_L: prefix##_##7c(); THREAD_NEXT; prefix##_##7d##_L: prefix##_##7d(); THREAD_NEXT; prefix##_##7e##_L: prefix##_##7e(); THREAD_NEXT; prefix##_##7f##_L: prefix##_##7f(); THREAD_NEXT; \
+	prefix##_##80##_L: prefix##_##80(); THREAD_NEXT; prefix##_##81##_L: prefix##_##81(); THREAD_NEXT; prefix##_##82##_L: prefix##_##82(); THREAD_NEXT; prefix##_##83##_L: prefix##_##83(); THREAD_NEXT; \
+	prefix##_##84##_L: prefix##_##84(); THREAD_NEXT; prefix##_##85##_L: prefix##_##85(); THREAD_NEXT; prefix##_##86##_L: prefix##_##86(); THREAD_NEXT; prefix##_##87##_L: prefix##_##87(); THREAD_NEXT; \
+	prefix##_##88##_L: prefix##_##88(); THREAD_NEXT; prefix##_##89##_L: prefix##_##89(); THREAD_NEXT; prefix##_##8a##_L: prefix##_##8a(); THREAD_NEXT; prefix##_##8b##_L: prefix##_##8b(); THREAD_NEXT; \
+	prefix##_##8c##_L: prefix##_##8c(); THREAD_NEXT; prefix##_##8d##_L: prefix##_##8d(); THREAD_NEXT; prefix##_##8e##_L: prefix##_##8e(); THREAD_NEXT; prefix##_##8f##_L: prefix##_##8f(); THREAD_NEXT; \
+	prefix##_##90##_L: prefix##_##90(); THREAD_NEXT; prefix##_##91##_L: prefix##_##91(); THREAD_NEXT; prefix##_##92##_L: prefix##_##92(); THREAD_NEXT; prefix##_##93##_L: prefix##_##93(); THREAD_NEXT; \
+	prefix##_##94##_L: prefix##_##94(); THREAD_NEXT; prefix##_##95##_L: prefix##_##95(); THREAD_NEXT; prefix##_##96##_L: prefix##_##96(); THREAD_NEXT; prefix##_##97##_L: prefix##_##97(); THREAD_NEXT; \
+	prefix##_##98##_L: prefix##_##98(); THREAD_NEXT; prefix##_##99##_L: prefix##_##99(); THREAD_NEXT; prefix##_##9a##_L: prefix##_##9a(); THREAD_NEXT; prefix##_##9b##_L: prefix##_##9b(); THREAD_NEXT; \
+	prefix##_##9c##_L: prefix##_##9c(); THREAD_NEXT; prefix##_##9d##_L: prefix##_##9d(); THREAD_NEXT; prefix##_##9e##_L: prefix##_##9e(); THREAD_NEXT; prefix##_##9f##_L: prefix##_##9f(); THREAD_NEXT; \
+	prefix##_##a0##_L: prefix##_##a0(); THREAD_NEXT; prefix##_##a1##_L: prefix##_##a1(); THREAD_NEXT; prefix##_##a2##_L: prefix##_##a2(); THREAD_NEXT; prefix##_##a3##_L: prefix##_##a3(); THREAD_NEXT; \
+	prefix##_##a4##_L: prefix##_##a4(); THREAD_NEXT; prefix##_##a5##_L: prefix##_##a5(); THREAD_NEXT; prefix##_##a6##_L: prefix##_##a6(); THREAD_NEXT; prefix##_##a7##_L: prefix##_##a7(); THREAD_NEXT; \
+	prefix##_##a8##_L: prefix##_##a8(); THREAD_NEXT; prefix##_##a9##_L: prefix##_##a9(); THREAD_NEXT; prefix##_##aa##_L: prefix##_##aa(); THREAD_NEXT; prefix##_##ab##_L: prefix##_##ab(); THREAD_NEXT; \
+	prefix##_##ac##_L: prefix##_##ac(); THREAD_NEXT; prefix##_##ad##_L: prefix##_##ad(); THREAD_NEXT; prefix##_##ae##_L: prefix##_##ae(); THREAD_NEXT; prefix##_##af##_L: prefix##_##af(); THREAD_NEXT; \
+	prefix##_##b0##_L: prefix##_##b0(); THREAD_NEXT; prefix##_##b1##_L: prefix##_##b1(); THREAD_NEXT; prefix##_##b2##_L: prefix##_##b2(); THREAD_NEXT; prefix##_##b3##_L: prefix##_##b3(); THREAD_NEXT; \
+	prefix##_##b4##_L: prefix##_##b4(); THREAD_NEXT; prefix##_##b5##_L: prefix##_##b5(); THREAD_NEXT; prefix##_##b6##_L: prefix##_##b6(); THREAD_NEXT; prefix##_##b7##_L: prefix##_##b7(); THREAD_NEXT; \
+	prefix##_##b8##_L: prefix##_##b8(); THREAD_NEXT; prefix##_##b9##_L: prefix##_##b9(); THREAD_NEXT; prefix##_##ba##_L: prefix##_##ba(); THREAD_NEXT; prefix##_##bb##_L: prefix##_##bb(); THREAD_NEXT; \
+	prefix##_##bc##_L: prefix##_##bc(); THREAD_NEXT; prefix##_##bd##_L: prefix##_##bd(); THREAD_NEXT; prefix##_##be##_L: prefix##_##be(); THREAD_NEXT; prefix##_##bf##_L: prefix##_##bf(); THREAD_NEXT; \
+	prefix##_##c0##_L: prefix##_##c0(); THREAD_NEXT; prefix##_##c1##_L: prefix##_##c1(); THREAD_NEXT; prefix##_##c2##_L: prefix##_##c2(); THREAD_NEXT; prefix##_##c3##_L: prefix##_##c3(); THREAD_NEXT; \
+	prefix##_##c4##_L: prefix##_##c4(); THREAD_NEXT; prefix##_##c5##_L: prefix##_##c5(); THREAD_NEXT; prefix##_##c6##_L: prefix##_##c6(); THREAD_NEXT; prefix##_##c7##_L: prefix##_##c7(); THREAD_NEXT; \
+	prefix##_##c8##_L: prefix##_##c8(); THREAD_NEXT; prefix##_##c9##_L: prefix##_##c9(); THREAD_NEXT; prefix##_##ca##_L: prefix##_##ca(); THREAD_NEXT; prefix##_##cc##_L: prefix##_##cc(); THREAD_NEXT; \
+	prefix##_##cd##_L: prefix##_##cd(); THREAD_NEXT; prefix##_##ce##_L: prefix##_##ce(); THREAD_NEXT; prefix##_##cf##_L: prefix##_##cf(); THREAD_NEXT; prefix##_##d0##_L: prefix##_##d0(); THREAD_NEXT; \
+	prefix##_##d1##_L: prefix##_##d1(); THREAD_NEXT; prefix##_##d2##_L: prefix##_##d2(); THREAD_NEXT; prefix##_##d3##_L: prefix##_##d3(); THREAD_NEXT; prefix##_##d4##_L: prefix##_##d4(); THREAD_NEXT; \
+	prefix##_##d5##_L: prefix##_##d5(); THREAD_NEXT; prefix##_##d6##_L: prefix##_##d6(); THREAD_NEXT; prefix##_##d7##_L: prefix##_##d7(); THREAD_NEXT; prefix##_##d8##_L: prefix##_##d8(); THREAD_NEXT; \
+	prefix##_##d9##_L: prefix##_##d9(); THREAD_NEXT; prefix##_##da##_L: prefix##_##da(); THREAD_NEXT; prefix##_##db##_L: prefix##_##db(); THREAD_NEXT; prefix##_##dc##_L: prefix##_##dc(); THREAD_NEXT; \
+	prefix##_##dd##_L: prefix##_##dd(); THREAD_NEXT; prefix##_##de##_L: prefix##_##de(); THREAD_NEXT; prefix##_##df##_L: prefix##_##df(); THREAD_NEXT; prefix##_##e0##_L: prefix##_##e0(); THREAD_NEXT; \
+	prefix##_##e1##_L: prefix##_##e1(); THREAD_NEXT; prefix##_##e2##_L: prefix##_##e2(); THREAD_NEXT; prefix##_##e3##_L: prefix##_##e3(); THREAD_NEXT; prefix##_##e4##_L: prefix##_##e4(); THREAD_NEXT; \
+	prefix##_##e5##_L: prefix##_##e5(); THREAD_NEXT; prefix##_##e6##_L: prefix##_##e6(); THREAD_NEXT; prefix##_##e7##_L: prefix##_##e7(); THREAD_NEXT; prefix##_##e8##_L: prefix##_##e8(); THREAD_NEXT; \
+	prefix##_##e9##_L: prefix##_##e9(); THREAD_NEXT; prefix##_##ea##_L: prefix##_##ea(); THREAD_NEXT; prefix##_##eb##_L: prefix##_##eb(); THREAD_NEXT; prefix##_##ec##_L: prefix##_##ec(); THREAD_NEXT; \
+	prefix##_##ed##_L: prefix##_##ed(); THREAD_NEXT; prefix##_##ee##_L: prefix##_##ee(); THREAD_NEXT; prefix##_##ef##_L: prefix##_##ef(); THREAD_NEXT; prefix##_##f0##_L: prefix##_##f0(); THREAD_NEXT; \
+	prefix##_##f1##_L: prefix##_##f1(); THREAD_NEXT; prefix##_##f2##_L: prefix##_##f2(); THREAD_NEXT; prefix##_##f3##_L: prefix##_##f3(); THREAD_NEXT; prefix##_##f4##_L: prefix##_##f4(); THREAD_NEXT; \
+	prefix##_##f5##_L: prefix##_##f5(); THREAD_NEXT; prefix##_##f6##_L: prefix##_##f6(); THREAD_NEXT; prefix##_##f7##_L: prefix##_##f7(); THREAD_NEXT; prefix##_##f8##_L: prefix##_##f8(); THREAD_NEXT; \
+	prefix##_##f9##_L: prefix##_##f9(); THREAD_NEXT; prefix##_##fa##_L: prefix##_##fa(); THREAD_NEXT; prefix##_##fb##_L: prefix##_##fb(); THREAD_NEXT; prefix##_##fc##_L: prefix##_##fc(); THREAD_NEXT; \
+	prefix##_##fd##_L: prefix##_##fd(); THREAD_NEXT; prefix##_##fe##_L: prefix##_##fe(); THREAD_NEXT; prefix##_##ff##_L: prefix##_##ff(); THREAD_NEXT;
+
+/* main table, the prefixes are threaded */
+#define THREAD_HANDLERS_OP(prefix)                          \
+	prefix##_##00##_L: prefix##_##00(); THREAD_NEXT; prefix##_##01##_L: prefix##_##01(); THREAD_NEXT; prefix##_##02##_L: prefix##_##02(); THREAD_NEXT; prefix##_##03##_L: prefix##_##03(); THREAD_NEXT; \
+	prefix##_##04##_L: prefix##_##04(); THREAD_NEXT; prefix##_##05##_L: prefix##_##05(); THREAD_NEXT; prefix##_##06##_L: prefix##_##06(); THREAD_NEXT; prefix##_##07##_L: prefix##_##07(); THREAD_NEXT; \
+	prefix##_##08##_L: prefix##_##08(); THREAD_NEXT; prefix##_##09##_L: prefix##_##09(); THREAD_NEXT; prefix##_##0a##_L: prefix##_##0a(); THREAD_NEXT; prefix##_##0b##_L: prefix##_##0b(); THREAD_NEXT; \
+	prefix##_##0c##_L: prefix##_##0c(); THREAD_NEXT; prefix##_##0d##_L: prefix##_##0d(); THREAD_NEXT; prefix##_##0e##_L: prefix##_##0e(); THREAD_NEXT; prefix##_##0f##_L: prefix##_##0f(); THREAD_NEXT; \
+	prefix##_##10##_L: prefix##_##10(); THREAD_NEXT; prefix##_##11##_L: prefix##_##11(); THREAD_NEXT; prefix##_##12##_L: prefix##_##12(); THREAD_NEXT; prefix##_##13##_L: prefix##_##13(); THREAD_NEXT; \
+	prefix##_##14##_L: prefix##_##14(); THREAD_NEXT; prefix##_##15##_L: prefix##_##15(); THREAD_NEXT; prefix##_##16##_L: prefix##_##16(); THREAD_NEXT; prefix##_##17##_L: prefix##_##17(); THREAD_NEXT; \
+	prefix##_##18##_L: prefix##_##18(); THREAD_NEXT; prefix##_##19##_L: prefix##_##19(); THREAD_NEXT; prefix##_##1a##_L: prefix##_##1a(); THREAD_NEXT; prefix##_##1b##_L: prefix##_##1b(); THREAD_NEXT; \
+	prefix##_##1c##_L: prefix##_##1c(); THREAD_NEXT; prefix##_##1d##_L: prefix##_##1d(); THREAD_NEXT; prefix##_##1e##_L: prefix##_##1e(); THREAD_NEXT; prefix##_##1f##_L: prefix##_##1f(); THREAD_NEXT; \
+	prefix##_##20##_L: prefix##_##20(); THREAD_NEXT; prefix##_##21##_L: prefix##_##21(); THREAD_NEXT; prefix##_##22##_L: prefix##_##22(); THREAD_NEXT; prefix##_##23##_L: prefix##_##23(); THREAD_NEXT; \
+	prefix##_##24##_L: prefix##_##24(); THREAD_NEXT; prefix##_##25##_L: prefix##_##25(); THREAD_NEXT; prefix##_##26##_L: prefix##_##26(); THREAD_NEXT; prefix##_##27##_L: prefix##_##27(); THREAD_NEXT; \
+	prefix##_##28##_L: prefix##_##28(); THREAD_NEXT; prefix##_##29##_L: prefix##_##29(); THREAD_NEXT; prefix##_##2a##_L: prefix##_##2a(); THREAD_NEXT; prefix##_##2b##_L: prefix##_##2b(); THREAD_NEXT; \
+	prefix##_##2c##_L: prefix##_##2c(); THREAD_NEXT; prefix##_##2d##_L: prefix##_##2d(); THREAD_NEXT; prefix##_##2e##_L: prefix##_##2e(); THREAD_NEXT; prefix##_##2f##_L: prefix##_##2f(); THREAD_NEXT; \
+	prefix##_##30##_L: prefix##_##30(); THREAD_NEXT; prefix##_##31##_L: prefix##_##31(); THREAD_NEXT; prefix##_##32##_L: prefix##_##32(); THREAD_NEXT; prefix##_##33##_L: prefix##_##33(); THREAD_NEXT; \
+	prefix##_##34##_L: prefix##_##34(); THREAD_NEXT; prefix##_##35##_L: prefix##_##35(); THREAD_NEXT; prefix##_##36##_L: prefix##_##36(); THREAD_NEXT; prefix##_##37##_L: prefix##_##37(); THREAD_NEXT; \
+	prefix##_##38##_L: prefix##_##38(); THREAD_NEXT; prefix##_##39##_L: prefix##_##39(); THREAD_NEXT; prefix##_##3a##_L: prefix##_##3a(); THREAD_NEXT; prefix##_##3b##_L: prefix##_##3b(); THREAD_NEXT; \
+	prefix##_##3c##_L: prefix##_##3c(); THREAD_NEXT; prefix##_##3d##_L: prefix##_##3d(); THREAD_NEXT; prefix##_##3e##_L: prefix##_##3e(); THREAD_NEXT; prefix##_##3f##_L: prefix##_##3f(); THREAD_NEXT; \
+	prefix##_##40##_L: prefix##_##40(); THREAD_NEXT; prefix##_##41##_L: prefix##_##41(); THREAD_NEXT; prefix##_##42##_L: prefix##_##42(); THREAD_NEXT; prefix##_##43##_L: prefix##_##43(); THREAD_NEXT; \
+	prefix##_##44##_L: prefix##_##44(); THREAD_NEXT; prefix##_##45##_L: prefix##_##45(); THREAD_NEXT; prefix##_##46##_L: prefix##_##46(); THREAD_NEXT; prefix##_##47##_L: prefix##_##47(); THREAD_NEXT; \
+	prefix##_##48##_L: prefix##_##48(); THREAD_NEXT; prefix##_##49##_L: prefix##_##49(); THREAD_NEXT; prefix##_##4a##_L: prefix##_##4a(); THREAD_NEXT; prefix##_##4b##_L: prefix##_##4b(); THREAD_NEXT; \
+	prefix##_##4c##_L: prefix##_##4c(); THREAD_NEXT; prefix##_##4d##_L: prefix##_##4d(); THREAD_NEXT; prefix##_##4e##_L: prefix##_##4e(); THREAD_NEXT; prefix##_##4f##_L: prefix##_##4f(); THREAD_NEXT; \
+	prefix##_##50##_L: prefix##_##50(); THREAD_NEXT; prefix##_##51##_L: prefix##_##51(); THREAD_NEXT; prefix##_##52##_L: prefix##_##52(); THREAD_NEXT; prefix##_##53##_L: prefix##_##53(); THREAD_NEXT; \
+	prefix##_##54##_L: prefix##_##54(); THREAD_NEXT; prefix##_##55##_L: prefix##_##55(); THREAD_NEXT; prefix##_##56##_L: prefix##_##56(); THREAD_NEXT; prefix##_##57##_L: prefix##_##57(); THREAD_NEXT; \
+	prefix##_##58##_L: prefix##_##58(); THREAD_NEXT; prefix##_##59##_L: prefix##_##59(); THREAD_NEXT; prefix##_##5a##_L: prefix##_##5a(); THREAD_NEXT; prefix##_##5b##_L: prefix##_##5b(); THREAD_NEXT; \
+	prefix##_##5c##_L: prefix##_##5c(); THREAD_NEXT; prefix##_##5d##_L: prefix##_##5d(); THREAD_NEXT; prefix##_##5e##_L: prefix##_##5e(); THREAD_NEXT; prefix##_##5f##_L: prefix##_##5f(); THREAD_NEXT; \
+	prefix##_##60##_L: prefix##_##60(); THREAD_NEXT; prefix##_##61##_L: prefix##_##61(); THREAD_NEXT; prefix##_##62##_L: prefix##_##62(); THREAD_NEXT; prefix##_##63##_L: prefix##_##63(); THREAD_NEXT; \
+	prefix##_##64##_L: prefix##_##64(); THREAD_NEXT; prefix##_##65##_L: prefix##_##65(); THREAD_NEXT; prefix##_##66##_L: prefix##_##66(); THREAD_NEXT; prefix##_##67##_L: prefix##_##67(); THREAD_NEXT; \
+	prefix##_##68##_L: prefix##_##68(); THREAD_NEXT; prefix##_##69##_L: prefix##_##69(); THREAD_NEXT; prefix##_##6a##_L: prefix##_##6a(); THREAD_NEXT; prefix##_##6b##_L: prefix##_##6b(); THREAD_NEXT; \
+	prefix##_##6c##_L: prefix##_##6c(); THREAD_NEXT; prefix##_##6d##_L: prefix##_##6d(); THREAD_NEXT; prefix##_##6e##_L: prefix##_##6e(); THREAD_NEXT; prefix##_##6f##_L: prefix##_##6f(); THREAD_NEXT; \
+	prefix##_##70##_L: prefix##_##70(); THREAD_NEXT; prefix##_##71##_L: prefix##_##71(); THREAD_NEXT; prefix##_##72##_L: prefix##_##72(); THREAD_NEXT; prefix##_##73##_L: prefix##_##73(); THREAD_NEXT; \
+	prefix##_##74##_L: prefix##_##74(); THREAD_NEXT; prefix##_##75##_L: prefix##_##75(); THREAD_NEXT; prefix##_##76##_L: prefix##_##76(); THREAD_NEXT; prefix##_##77##_L: prefix##_##77(); THREAD_NEXT; \
+	prefix##_##78##_L: prefix##_##78(); THREAD_NEXT; prefix##_##79##_L: prefix##_##79(); THREAD_NEXT; prefix##_##7a##_L: prefix##_##7a(); THREAD_NEXT; prefix##_##7b##_L: prefix##_##7b(); THREAD_NEXT; \
+	prefix##_##7c##_L: prefix##_##7c(); THREAD_NEXT; prefix##_##7d##_L: prefix##_##7d(); THREAD_NEXT; prefix##_##7e##_L: prefix##_##7e(); THREAD_NEXT; prefix##_##7f##_L: prefix##_##7f(); THREAD_NEXT; \
+	prefix##_##80##_L: prefix##_##80(); THREAD_NEXT; prefix##_##81##_L: prefix##_##81(); THREAD_NEXT; prefix##_##82##_L: prefix##_##82(); THREAD_NEXT; prefix##_##83##_L: prefix##_##83(); THREAD_NEXT; \
+	prefix##_##84##_L: prefix##_##84(); THREAD_NEXT; prefix##_##85##_L: prefix##_##85(); THREAD_NEXT; prefix##_##86##_L: prefix##_##86(); THREAD_NEXT; prefix##_##87##_L: prefix##_##87(); THREAD_NEXT; \
+	prefix##_##88##_L: prefix##_##88(); THREAD_NEXT; prefix##_##89##_L: prefix##_##89(); THREAD_NEXT; prefix##_##8a##_L: prefix##_##8a(); THREAD_NEXT; prefix##_##8b##_L: prefix##_##8b(); THREAD_NEXT; \
+	prefix##_##8c##_L: prefix##_##8c(); THREAD_NEXT; prefix##_##8d##_L: prefix##_##8d(); THREAD_NEXT; prefix##_##8e##_L: prefix##_##8e(); THREAD_NEXT; prefix##_##8f##_L: prefix##_##8f(); THREAD_NEXT; \
+	prefix##_##90##_L: prefix##_##90(); THREAD_NEXT; prefix##_##91##_L: prefix##_##91(); THREAD_NEXT; prefix##_##92##_L: prefix##_##92(); THREAD_NEXT; prefix##_##93##_L: prefix##_##93(); THREAD_NEXT; \
+	prefix##_##94##_L: prefix##_##94(); THREAD_NEXT; prefix##_##95##_L: prefix##_##95(); THREAD_NEXT; prefix##_##96##_L: prefix##_##96(); THREAD_NEXT; prefix##_##97##_L: prefix##_##97(); THREAD_NEXT; \
+	prefix##_##98##_L: prefix##_##98(); THREAD_NEXT; prefix##_##99##_L: prefix##_##99(); THREAD_NEXT; prefix##_##9a##_L: prefix##_##9a(); THREAD_NEXT; prefix##_##9b##_L: prefix##_##9b(); THREAD_NEXT; \
+	prefix##_##9c##_L: prefix##_##9c(); THREAD_NEXT; prefix##_##9d##_L: prefix##_##9d(); THREAD_NEXT; prefix##_##9e##_L: prefix##_##9e(); THREAD_NEXT; prefix##_##9f##_L: prefix##_##9f(); THREAD_NEXT; \
+	prefix##_##a0##_L: prefix##_##a0(); THREAD_NEXT; prefix##_##a1##_L: prefix##_##a1(); THREAD_NEXT; prefix##_##a2##_L: prefix##_##a2(); THREAD_NEXT; prefix##_##a3##_L: prefix##_##a3(); THREAD_NEXT; \
+	prefix##_##a4##_L: prefix##_##a4(); THREAD_NEXT; prefix##_##a5##_L: prefix##_##a5(); THREAD_NEXT; prefix##_##a6##_L: prefix##_##a6(); THREAD_NEXT; prefix##_##a7##_L: prefix##_##a7(); THREAD_NEXT; \
+	prefix##_##a8##_L: prefix##_##a8(); THREAD_NEXT; prefix##_##a9##_L: prefix##_##a9(); THREAD_NEXT; prefix##_##aa##_L: prefix##_##aa(); THREAD_NEXT; prefix##_##ab##_L: prefix##_##ab(); THREAD_NEXT; \
+	prefix##_##ac##_L: prefix##_##ac(); THREAD_NEXT; prefix##_##ad##_L: prefix##_##ad(); THREAD_NEXT; prefix##_##ae##_L: prefix##_##ae(); THREAD_NEXT; prefix##_##af##_L: prefix##_##af(); THREAD_NEXT; \
+	prefix##_##b0##_L: prefix##_##b0(); THREAD_NEXT; prefix##_##b1##_L: prefix##_##b1(); THREAD_NEXT; prefix##_##b2##_L: prefix##_##b2(); THREAD_NEXT; prefix##_##b3##_L: prefix##_##b3(); THREAD_NEXT; \
+	prefix##_##b4##_L: prefix##_##b4(); THREAD_NEXT; prefix##_##b5##_L: prefix##_##b5(); THREAD_NEXT; prefix##_##b6##_L: prefix##_##b6(); THREAD_NEXT; prefix##_##b7##_L: prefix##_##b7(); THREAD_NEXT; \
+	prefix##_##b8##_L: prefix##_##b8(); THREAD_NEXT; prefix##_##b9##_L: prefix##_##b9(); THREAD_NEXT; prefix##_##ba##_L: prefix##_##ba(); THREAD_NEXT; prefix##_##bb##_L: prefix##_##bb(); THREAD_NEXT; \
+	prefix##_##bc##_L: prefix##_##bc(); THREAD_NEXT; prefix##_##bd##_L: prefix##_##bd(); THREAD_NEXT; prefix##_##be##_L: prefix##_##be(); THREAD_NEXT; prefix##_##bf##_L: prefix##_##bf(); THREAD_NEXT; \
+	prefix##_##c0##_L: prefix##_##c0(); THREAD_NEXT; prefix##_##c1##_L: prefix##_##c1(); THREAD_NEXT; prefix##_##c2##_L: prefix##_##c2(); THREAD_NEXT; prefix##_##c3##_L: prefix##_##c3(); THREAD_NEXT; \
+	prefix##_##c4##_L: prefix##_##c4(); THREAD_NEXT; prefix##_##c5##_L: prefix##_##c5(); THREAD_NEXT; prefix##_##c6##_L: prefix##_##c6(); THREAD_NEXT; prefix##_##c7##_L: prefix##_##c7(); THREAD_NEXT; \
+	prefix##_##c8##_L: prefix##_##c8(); THREAD_NEXT; prefix##_##c9##_L: prefix##_##c9(); THREAD_NEXT; prefix##_##ca##_L: prefix##_##ca(); THREAD_NEXT; prefix##_##cc##_L: prefix##_##cc(); THREAD_NEXT; \
+	prefix##_##cd##_L: prefix##_##cd(); THREAD_NEXT; prefix##_##ce##_L: prefix##_##ce(); THREAD_NEXT; prefix##_##cf##_L: prefix##_##cf(); THREAD_NEXT; prefix##_##d0##_L: prefix##_##d0(); THREAD_NEXT; \
+	prefix##_##d1##_L: prefix##_##d1(); THREAD_NEXT; prefix##_##d2##_L: prefix##_##d2(); THREAD_NEXT; prefix##_##d3##_L: prefix##_##d3(); THREAD_NEXT; prefix##_##d4##_L: prefix##_##d4(); THREAD_NEXT; \
+	prefix##_##d5##_L: prefix##_##d5(); THREAD_NEXT; prefix##_##d6##_L: prefix##_##d6(); THREAD_NEXT; prefix##_##d7##_L: prefix##_##d7(); THREAD_NEXT; prefix##_##d8##_L: prefix##_##d8(); THREAD_NEXT; \
+	prefix##_##d9##_L: prefix##_##d9(); THREAD_NEXT; prefix##_##da##_L: prefix##_##da(); THREAD_NEXT; prefix##_##db##_L: prefix##_##db(); THREAD_NEXT; prefix##_##dc##_L: prefix##_##dc(); THREAD_NEXT; \
+	prefix##_##de##_L: prefix##_##de(); THREAD_NEXT; prefix##_##df##_L: prefix##_##df(); THREAD_NEXT; prefix##_##e0##_L: prefix##_##e0(); THREAD_NEXT; prefix##_##e1##_L: prefix##_##e1(); THREAD_NEXT; \
+	prefix##_##e2##_L: prefix##_##e2(); THREAD_NEXT; prefix##_##e3##_L: prefix##_##e3(); THREAD_NEXT; prefix##_##e4##_L: prefix##_##e4(); THREAD_NEXT; prefix##_##e5##_L: prefix##_##e5(); THREAD_NEXT; \
+	prefix##_##e6##_L: prefix##_##e6(); THREAD_NEXT; prefix##_##e7##_L: prefix##_##e7(); THREAD_NEXT; prefix##_##e8##_L: prefix##_##e8(); THREAD_NEXT; prefix##_##e9##_L: prefix##_##e9(); THREAD_NEXT; \
+	prefix##_##ea##_L: prefix##_##ea(); THREAD_NEXT; prefix##_##eb##_L: prefix##_##eb(); THREAD_NEXT; prefix##_##ec##_L: prefix##_##ec(); THREAD_NEXT; prefix##_##ee##_L: prefix##_##ee(); THREAD_NEXT; \
+	prefix##_##ef##_L: prefix##_##ef(); THREAD_NEXT; prefix##_##f0##_L: prefix##_##f0(); THREAD_NEXT; prefix##_##f1##_L: prefix##_##f1(); THREAD_NEXT; prefix##_##f2##_L: prefix##_##f2(); THREAD_NEXT; \
+	prefix##_##f3##_L: prefix##_##f3(); THREAD_NEXT; prefix##_##f4##_L: prefix##_##f4(); THREAD_NEXT; prefix##_##f5##_L: prefix##_##f5(); THREAD_NEXT; prefix##_##f6##_L: prefix##_##f6(); THREAD_NEXT; \
+	prefix##_##f7##_L: prefix##_##f7(); THREAD_NEXT; prefix##_##f8##_L: prefix##_##f8(); THREAD_NEXT; prefix##_##f9##_L: prefix##_##f9(); THREAD_NEXT; prefix##_##fa##_L: prefix##_##fa(); THREAD_NEXT; \
+	prefix##_##fb##_L: prefix##_##fb(); THREAD_NEXT; prefix##_##fc##_L: prefix##_##fc(); THREAD_NEXT; prefix##_##fe##_L: prefix##_##fe(); THREAD_NEXT; prefix##_##ff##_L: prefix##_##ff(); THREAD_NEXT;
+#endif
+
+
 /***************************************************************
  * Enter HALT state; write 1 to fake port on first execution
  ***************************************************************/
@@ -612,12 +1076,25 @@ MAME_INLINE void BURNODD(int cycles, int opcodes, int cyclesum)
 /***************************************************************
  * Input a byte from given I/O port
  ***************************************************************/
+#if IDLE_LOOP_HACKS
+MAME_INLINE UINT8 IN( UINT32 port )
+{
+	if( !cpu_idleport16 || !(*cpu_idleport16)(port) )
+		idle_dirty = 1;
+	return (UINT8)cpu_readport16(port);
+}
+#else
 #define IN(port)   ((UINT8)cpu_readport16(port))
+#endif
 
 /***************************************************************
  * Output a byte to given I/O port
  ***************************************************************/
+#if IDLE_LOOP_HACKS
+#define OUT(port,value) (idle_dirty = 1, cpu_writeport16(port,value))
+#else
 #define OUT(port,value) cpu_writeport16(port,value)
+#endif
 
 /***************************************************************
  * Read a byte from given memory location
@@ -629,24 +1106,68 @@ MAME_INLINE void BURNODD(int cycles, int opcodes, int cyclesum)
  ***************************************************************/
 MAME_INLINE void RM16( UINT32 addr, PAIR *r )
 {
+	/* both bytes in one page need a single cpu_readmap[] lookup */
+	if( (addr & 0x3ff) != 0x3ff )
+	{
+		const UINT8 *p = &cpu_readmap[addr >> 10][addr & 0x3ff];
+		r->b.l = p[0];
+		r->b.h = p[1];
+		return;
+	}
 	r->b.l = RM(addr);
 	r->b.h = RM((addr+1)&0xffff);
 }
 
 /***************************************************************
- * Write a byte to given memory location
+ * Write a byte to given memory location. Only pages that need
+ * it (cpu_writeattr[]) go through the cpu_writemem16 handler
  ***************************************************************/
-#define WM(addr,value) cpu_writemem16(addr,value)
+MAME_INLINE void WM( UINT32 addr, UINT32 value )
+{
+	unsigned attr = cpu_writeattr[addr >> 10];
+#if IDLE_LOOP_HACKS
+	idle_dirty = 1;
+#endif
+	if( attr == Z80_PAGE_RAM )
+		cpu_writemap[addr >> 10][addr & 0x3ff] = value;
+	else
+	if( attr != Z80_PAGE_ROM )
+		cpu_writemem16(addr,value);
+}
 
 /***************************************************************
  * Write a word to given memory location
  ***************************************************************/
 MAME_INLINE void WM16( UINT32 addr, PAIR *r )
 {
+	/* both bytes in one page of RAM need a single lookup */
+	if( (addr & 0x3ff) != 0x3ff && cpu_writeattr[addr >> 10] == Z80_PAGE_RAM )
+	{
+		UINT8 *p = &cpu_writemap[addr >> 10][addr & 0x3ff];
+#if IDLE_LOOP_HACKS
+		idle_dirty = 1;
+#endif
+		p[0] = r->b.l;
+		p[1] = r->b.h;
+		return;
+	}
 	WM(addr,r->b.l);
 	WM((addr+1)&0xffff,r->b.h);
 }
 
+/***************************************************************
+ * Read a byte of code, moving the code page if the PC has left it
+ ***************************************************************/
+MAME_INLINE UINT8 code_read(unsigned pc)
+{
+	if( (pc >> 10) != code_page )
+	{
+		code_page = pc >> 10;
+		code_ptr = cpu_readmap[code_page];
+	}
+	return code_ptr[pc & 0x3ff];
+}
+
 /***************************************************************
  * ROP() is identical to RM() except it is used for
  * reading opcodes. In case of system with memory mapped I/O,
@@ -659,7 +1180,7 @@ MAME_INLINE UINT8 ROP(void)
 	if ( !(pc & 0x1fff) ) change_pc16 (pc);
 #endif
 	_PC++;
-	return cpu_readop(pc);
+	return code_read(pc);
 }
 
 /****************************************************************
@@ -675,7 +1196,7 @@ MAME_INLINE UINT8 ARG(void)
 	if ( !(pc & 0x1fff) ) change_pc16 (pc);
 #endif
 	_PC++;
-	return cpu_readop_arg(pc);
+	return code_read(pc);
 }
 
 MAME_INLINE UINT32 ARG16(void)
@@ -685,8 +1206,12 @@ MAME_INLINE UINT32 ARG16(void)
 	return ret | ((ARG()&0xffff) << 8);
 #else
 	unsigned pc = _PCD;
+	unsigned lo;
 	_PC += 2;
-	return cpu_readop_arg(pc) | (cpu_readop_arg((pc+1)&0xffff) << 8);
+	lo = code_read(pc);
+	if( (pc & 0x3ff) != 0x3ff )
+		return lo | (code_ptr[(pc & 0x3ff) + 1] << 8);
+	return lo | (code_read((pc+1)&0xffff) << 8);
 #endif
 }
 
@@ -707,6 +1232,67 @@ MAME_INLINE UINT32 ARG16(void)
  ***************************************************************/
 #define PUSH(SR) { _SP -= 2; WM16( _SPD, &Z80.SR ); }
 
+/***************************************************************
+ * IDLE_LOOP
+ * A loop that writes nothing, reads only memory and idle ports
+ * and comes back to its branch with the same registers will run
+ * the same iteration until the time slice ends. All but the last
+ * of those iterations are skipped; the last runs as usual, so
+ * the slice ends exactly where it would have. An iteration in
+ * which a port handler cut the slice short (z80_end_slice())
+ * isn't used to measure the loop.
+ ***************************************************************/
+#if IDLE_LOOP_HACKS
+static void idle_loop(unsigned pc)
+{
+	/* per-game hacks (hacks.c) may end the slice right away */
+	if( cpu_idlepc16 && (*cpu_idlepc16)(pc) )
+	{
+		if( !after_EI )
+#ifdef Z80_MSX
+			z80_msx_burn( Z80_ICOUNT );
+#else
+			z80_burn( Z80_ICOUNT );
+#endif
+		return;
+	}
+
+	if( pc == idle_pc && !idle_dirty && !after_EI &&
+		z80_requested_cycles == idle_requested &&
+		_AFD == idle_regs.AF.d && _BCD == idle_regs.BC.d &&
+		_DED == idle_regs.DE.d && _HLD == idle_regs.HL.d &&
+		_IXD == idle_regs.IX.d && _IYD == idle_regs.IY.d &&
+		_SPD == idle_regs.SP.d && Z80.AF2.d == idle_regs.AF2.d &&
+		Z80.BC2.d == idle_regs.BC2.d && Z80.DE2.d == idle_regs.DE2.d &&
+		Z80.HL2.d == idle_regs.HL2.d && _IFF1 == idle_regs.IFF1 &&
+		_IFF2 == idle_regs.IFF2 && _IM == idle_regs.IM && _I == idle_regs.I )
+	{
+		int cycles = idle_icount - Z80_ICOUNT;
+		if( ++idle_count >= IDLE_LOOP_COUNT && cycles > 0 && Z80_ICOUNT > cycles )
+		{
+			int n = (Z80_ICOUNT - 1) / cycles;
+			Z80_ICOUNT -= n * cycles;
+			_R += n * (UINT8)(_R - idle_r);
+			idle_count = 0;
+		}
+	}
+	else
+	{
+		idle_pc = pc;
+		idle_regs = Z80;
+		idle_count = 0;
+	}
+	idle_icount = Z80_ICOUNT;
+	idle_requested = z80_requested_cycles;
+	idle_r = _R;
+	idle_dirty = 0;
+}
+
+#define IDLE_LOOP(pc) { if( _PCD < (pc) ) idle_loop(pc); }
+#else
+#define IDLE_LOOP(pc)	(void)(pc)
+#endif
+
 /***************************************************************
  * JP
  ***************************************************************/
@@ -743,11 +1329,14 @@ MAME_INLINE UINT32 ARG16(void)
 					2, cc[Z80_TABLE_op][0x31]+cc[Z80_TABLE_op][0xc3]); \
 		}														\
 	}															\
+	IDLE_LOOP(oldpc);											\
 }
 #else
 #define JP {													\
+	unsigned oldpc = _PCD-1;									\
 	_PCD = ARG16(); 											\
 	change_pc16(_PCD);											\
+	IDLE_LOOP(oldpc);											\
 }
 #endif
 
@@ -758,8 +1347,10 @@ MAME_INLINE UINT32 ARG16(void)
 #define JP_COND(cond)											\
 	if( cond )													\
 	{															\
+		unsigned oldpc = _PCD-1;								\
 		_PCD = ARG16(); 										\
 		change_pc16(_PCD);										\
+		IDLE_LOOP(oldpc);										\
 	}															\
 	else														\
 	{															\
@@ -803,6 +1394,7 @@ MAME_INLINE UINT32 ARG16(void)
 				   2, cc[Z80_TABLE_op][0x31]+cc[Z80_TABLE_op][0x18]); \
 		}														\
 	}															\
+	IDLE_LOOP(oldpc);											\
 }
 
 /***************************************************************
@@ -811,10 +1403,14 @@ MAME_INLINE UINT32 ARG16(void)
 #define JR_COND(cond,opcode)									\
 	if( cond )													\
 	{															\
+		unsigned oldpc = _PCD-1;								\
 		INT8 arg = (INT8)ARG(); /* ARG() also increments _PC */ \
 		_PC += arg; 			/* so don't do _PC += ARG() */  \
 		CC(ex,opcode);											\
 		change_pc16(_PCD);										\
+		/* DJNZ changes B on every iteration */ 				\
+		if( opcode != 0x10 )									\
+			IDLE_LOOP(oldpc);									\
 	}															\
 	else _PC++; 												\
 
@@ -824,6 +1420,7 @@ MAME_INLINE UINT32 ARG16(void)
 #define CALL()													\
 	EA = ARG16();												\
 	PUSH( PC ); 												\
+	PROFILE_CALL(EA);											\
 	_PCD = EA;													\
 	change_pc16(_PCD)
 
@@ -835,6 +1432,7 @@ MAME_INLINE UINT32 ARG16(void)
 	{															\
 		EA = ARG16();											\
 		PUSH( PC ); 											\
+		PROFILE_CALL(EA);										\
 		_PCD = EA;												\
 		CC(ex,opcode);											\
 		change_pc16(_PCD);										\
@@ -850,6 +1448,7 @@ MAME_INLINE UINT32 ARG16(void)
 #define RET_COND(cond,opcode)									\
 	if( cond )													\
 	{															\
+		PROFILE_RET();											\
 		POP(PC);												\
 		change_pc16(_PCD);										\
 		CC(ex,opcode);											\
@@ -860,13 +1459,13 @@ MAME_INLINE UINT32 ARG16(void)
  ***************************************************************/
 #define RETN	{												\
     LOG(("Z80 #%d RETN IFF1:%d IFF2:%d\n", 0, _IFF1, _IFF2)); \
+	PROFILE_RET();												\
 	POP(PC);													\
 	change_pc16(_PCD);											\
 	if( _IFF1 == 0 && _IFF2 == 1 )								\
 	{															\
 		_IFF1 = 1;												\
-		if( Z80.irq_state != CLEAR_LINE ||						\
-			Z80.request_irq >= 0 )								\
+		if( Z80.irq_state != CLEAR_LINE || DAISY_PENDING )		\
 		{														\
 			LOG(("Z80 #%d RETN takes IRQ\n",                    \
                 0));                           \
@@ -879,12 +1478,9 @@ MAME_INLINE UINT32 ARG16(void)
 /***************************************************************
  * RETI
  ***************************************************************/
-#define RETI	{												\
+#if Z80_DAISY_CHAIN
+#define DAISY_RETI {											\
 	int device = Z80.service_irq;								\
-	POP(PC);													\
-	change_pc16(_PCD);											\
-/* according to http://www.msxnet.org/tech/Z80/z80undoc.txt */	\
-/*	_IFF1 = _IFF2;	*/											\
 	if( device >= 0 )											\
 	{															\
 		LOG(("Z80 #%d RETI device %d: $%02x\n",                 \
@@ -892,6 +1488,18 @@ MAME_INLINE UINT32 ARG16(void)
 		Z80.irq[device].interrupt_reti(Z80.irq[device].irq_param); \
 	}															\
 }
+#else
+#define DAISY_RETI
+#endif
+
+#define RETI	{												\
+	PROFILE_RET();												\
+	POP(PC);													\
+	change_pc16(_PCD);											\
+/* according to http://www.msxnet.org/tech/Z80/z80undoc.txt */	\
+/*	_IFF1 = _IFF2;	*/											\
+	DAISY_RETI; 												\
+}
 
 /***************************************************************
  * LD	R,A
@@ -929,6 +1537,7 @@ MAME_INLINE UINT32 ARG16(void)
  ***************************************************************/
 #define RST(addr)												\
 	PUSH( PC ); 												\
+	PROFILE_CALL(addr);											\
 	_PCD = addr;												\
 	change_pc16(_PCD)
 
@@ -1987,6 +2596,121 @@ MAME_INLINE UINT8 SET(UINT8 bit, UINT8 value)
 		CC(ex,0xbb);											\
 	}
 
+/***************************************************************
+ * OTIR_BLOCK, INIR_BLOCK, OUTI_BLOCK
+ * All but the last of the iterations (or OUTIs) that would run
+ * before the time slice ends are done in one go, with the cycles
+ * and R they would have taken. The flags only depend on the last
+ * byte, so the last one runs as usual afterwards. The bytes must
+ * lie in one 1K page of memory.
+ ***************************************************************/
+#if BLOCK_IO_HACKS
+/* iterations of a repeated instruction that would run before the
+   slice ends, not counting the one being executed */
+static int block_repeats(unsigned op)
+{
+	int ed = cc[Z80_TABLE_ed][op], ex = cc[Z80_TABLE_ex][op];
+
+	if( Z80_ICOUNT <= ex )
+		return 0;
+	return (Z80_ICOUNT + ed - 1) / (ed + ex);
+}
+
+static void otir_block(void)
+{
+	unsigned hl = _HLD;
+	int n = block_repeats(0xb3);
+
+	/* B reaching zero ends the loop */
+	if( n > ((_B - 1) & 0xff) )
+		n = (_B - 1) & 0xff;
+	if( n > 0x400 - (int)(hl & 0x3ff) )
+		n = 0x400 - (hl & 0x3ff);
+	if( n <= 0 || !cpu_writeblock16 ||
+		!(*cpu_writeblock16)((((_B - 1) & 0xff) << 8) | _C,
+			&cpu_readmap[hl >> 10][hl & 0x3ff], n) )
+		return;
+
+	_B -= n;
+	_HL += n;
+	_R += 2 * n;
+	Z80_ICOUNT -= n * (cc[Z80_TABLE_ed][0xb3] + cc[Z80_TABLE_ex][0xb3]);
+#if IDLE_LOOP_HACKS
+	idle_dirty = 1;
+#endif
+}
+
+static void inir_block(void)
+{
+	UINT8 buf[0x100];
+	unsigned hl = _HLD, pc = _PCD - 2;
+	int n = block_repeats(0xb2), i;
+
+	if( n > ((_B - 1) & 0xff) )
+		n = (_B - 1) & 0xff;
+	if( n > 0x400 - (int)(hl & 0x3ff) )
+		n = 0x400 - (hl & 0x3ff);
+
+	/* the writes must not change the INIR itself or the page it is
+	   in, so only plain RAM below the Sega mapper registers is taken */
+	if( n <= 0 || cpu_writemap[hl >> 10] != cpu_readmap[hl >> 10] ||
+		hl + n > 0xfffc || (hl < pc + 2 && hl + n > pc) ||
+		!cpu_readblock16 || !(*cpu_readblock16)(_BC, buf, n) )
+		return;
+
+	for( i = 0; i < n; i++ )
+		WM( hl + i, buf[i] );
+
+	_B -= n;
+	_HL += n;
+	_R += 2 * n;
+	Z80_ICOUNT -= n * (cc[Z80_TABLE_ed][0xb2] + cc[Z80_TABLE_ex][0xb2]);
+#if IDLE_LOOP_HACKS
+	idle_dirty = 1;
+#endif
+}
+
+static void outi_block(void)
+{
+	unsigned pc = _PCD, hl = _HLD;
+	const UINT8 *code = &cpu_readmap[pc >> 10][pc & 0x3ff];
+	int ed = cc[Z80_TABLE_ed][0xa3];
+	int max = Z80_ICOUNT > 0 ? (Z80_ICOUNT + ed - 1) / ed : 0;
+	int n = 0;
+
+	/* the OUTIs that follow in the same page and would run in this
+	   slice, the last of them runs as usual */
+	if( max > (int)(0x400 - (hl & 0x3ff)) )
+		max = 0x400 - (hl & 0x3ff);
+	while( n < max && (pc & 0x3ff) + 2 * n + 2 <= 0x400 &&
+		code[2 * n] == 0xed && code[2 * n + 1] == 0xa3 )
+		n++;
+
+	if( n == 0 || !cpu_writeblock16 ||
+		!(*cpu_writeblock16)((((_B - 1) & 0xff) << 8) | _C,
+			&cpu_readmap[hl >> 10][hl & 0x3ff], n) )
+		return;
+
+	_B -= n;
+	_HL += n;
+	_R += 2 * n;
+	_PC += 2 * n;
+	_PPC = _PCD - 2;
+	Z80_ICOUNT -= n * ed;
+#if IDLE_LOOP_HACKS
+	idle_dirty = 1;
+#endif
+}
+
+#define OTIR_BLOCK	otir_block()
+#define INIR_BLOCK	inir_block()
+#define OUTI_BLOCK	outi_block()
+#else
+#define OTIR_BLOCK
+#define INIR_BLOCK
+#define OUTI_BLOCK
+#endif
+
 /***************************************************************
  * EI
  ***************************************************************/
@@ -2009,8 +2733,7 @@ MAME_INLINE UINT8 SET(UINT8 bit, UINT8 value)
 			_PC++;												\
 			_R++;												\
 		}														\
-		if( Z80.irq_state != CLEAR_LINE ||						\
-			Z80.request_irq >= 0 )								\
+		if( Z80.irq_state != CLEAR_LINE || DAISY_PENDING )		\
 		{														\
 			after_EI = 1;	/* avoid cycle skip hacks */		\
 			EXEC(op,ROP()); 									\
@@ -3381,7 +4104,7 @@ OP(ed,9f) { illegal_2();											} /* DB   ED		  */
 OP(ed,a0) { LDI;													} /* LDI			  */
 OP(ed,a1) { CPI;													} /* CPI			  */
 OP(ed,a2) { INI;													} /* INI			  */
-OP(ed,a3) { OUTI;													} /* OUTI			  */
+OP(ed,a3) { OUTI_BLOCK; OUTI;										} /* OUTI			  */
 OP(ed,a4) { illegal_2();											} /* DB   ED		  */
 OP(ed,a5) { illegal_2();											} /* DB   ED		  */
 OP(ed,a6) { illegal_2();											} /* DB   ED		  */
@@ -3398,8 +4121,8 @@ OP(ed,af) { illegal_2();											} /* DB   ED		  */
 
 OP(ed,b0) { LDIR;													} /* LDIR			  */
 OP(ed,b1) { CPIR;													} /* CPIR			  */
-OP(ed,b2) { INIR;													} /* INIR			  */
-OP(ed,b3) { OTIR;													} /* OTIR			  */
+OP(ed,b2) { INIR_BLOCK; INIR;										} /* INIR			  */
+OP(ed,b3) { OTIR_BLOCK; OTIR;										} /* OTIR			  */
 OP(ed,b4) { illegal_2();											} /* DB   ED		  */
 OP(ed,b5) { illegal_2();											} /* DB   ED		  */
 OP(ed,b6) { illegal_2();											} /* DB   ED		  */
@@ -3855,7 +4578,7 @@ OP(op,c6) { ADD(ARG()); 											} /* ADD  A,n		  */
 OP(op,c7) { RST(0x00);												} /* RST  0 		  */
 
 OP(op,c8) { RET_COND( _F & ZF, 0xc8 );								} /* RET  Z 		  */
-OP(op,c9) { POP(PC); change_pc16(_PCD); 							} /* RET			  */
+OP(op,c9) { PROFILE_RET(); POP(PC); change_pc16(_PCD);				} /* RET			  */
 OP(op,ca) { JP_COND( _F & ZF ); 									} /* JP   Z,a		  */
 OP(op,cb) { _R++; EXEC(cb,ROP());									} /* **** CB xx 	  */
 OP(op,cc) { CALL_COND( _F & ZF, 0xcc ); 							} /* CALL Z,a		  */
@@ -3930,6 +4653,7 @@ static void take_interrupt(void)
 		/* Check if processor was halted */
 		LEAVE_HALT;
 
+#if Z80_DAISY_CHAIN
 		if( Z80.irq_max )			/* daisy chain mode */
 		{
 			if( Z80.request_irq >= 0 )
@@ -3942,6 +4666,7 @@ static void take_interrupt(void)
 			} else return;
 		}
 		else
+#endif
 		{
 			/* Clear both interrupt flip flops */
 			_IFF1 = _IFF2 = 0;
@@ -3956,6 +4681,7 @@ static void take_interrupt(void)
 			irq_vector = (irq_vector & 0xff) | (_I << 8);
 			PUSH( PC );
 			RM16( irq_vector, &Z80.PC );
+			PROFILE_CALL(_PCD);
             LOG(("Z80 #%d IM2 [$%04x] = $%04x\n",0 , irq_vector, _PCD));
 			/* CALL opcode timing */
 			Z80.extra_cycles += cc[Z80_TABLE_op][0xcd];
@@ -3967,6 +4693,7 @@ static void take_interrupt(void)
             LOG(("Z80 #%d IM1 $0038\n",0 ));
 			PUSH( PC );
 			_PCD = 0x0038;
+			PROFILE_CALL(_PCD);
 			/* RST $38 + 'interrupt latency' cycles */
 			Z80.extra_cycles += cc[Z80_TABLE_op][0xff] + cc[Z80_TABLE_ex][0xff];
 		}
@@ -3981,6 +4708,7 @@ static void take_interrupt(void)
 				case 0xcd0000:	/* call */
 					PUSH( PC );
 					_PCD = irq_vector & 0xffff;
+					PROFILE_CALL(_PCD);
 					 /* CALL $xxxx + 'interrupt latency' cycles */
 					Z80.extra_cycles += cc[Z80_TABLE_op][0xcd] + cc[Z80_TABLE_ex][0xff];
 					break;
@@ -3992,6 +4720,7 @@ static void take_interrupt(void)
 				default:		/* rst (or other opcodes?) */
 					PUSH( PC );
 					_PCD = irq_vector & 0x0038;
+					PROFILE_CALL(_PCD);
 					/* RST $xx + 2 cycles */
 					Z80.extra_cycles += cc[Z80_TABLE_op][_PCD] + cc[Z80_TABLE_ex][_PCD];
 					break;
@@ -4001,6 +4730,157 @@ static void take_interrupt(void)
 	}
 }
 
+#if Z80_ICACHE
+/****************************************************************************
+ * Instruction cache. ROM is decoded once per physical 1K page; a slot is
+ * pointed at the decoded page when its cpu_readmap[] entry changes, so a
+ * mapper write only invalidates the slots it remaps. Code outside the ROM
+ * (RAM, cartridge RAM) is never cached and runs through the normal path.
+ ****************************************************************************/
+static void icache_map(unsigned slot)
+{
+	UINT8 *base = cpu_readmap[slot];
+	int offset = base - icache_rom;
+
+	icache_tag[slot] = base;
+	icache_slot[slot] = NULL;
+
+	if( !icache_rom || base < icache_rom || offset >= icache_size || (offset & 0x3ff) )
+		return;
+
+	if( !icache_page[offset >> 10] )
+	{
+		icache_page[offset >> 10] = calloc(0x400, sizeof(Z80_Decoded));
+		if( !icache_page[offset >> 10] )
+			return;
+	}
+
+	icache_slot[slot] = icache_page[offset >> 10];
+}
+
+static void icache_decode(Z80_Decoded *d, unsigned pc)
+{
+	const funcptr *table;
+	const UINT8 *cycles;
+	unsigned op = cpu_readop(pc);
+
+	d->handler = Z80op[op];
+	d->cycles = cc[Z80_TABLE_op][op];
+	d->length = 1;
+	d->prefix = 0;
+	d->op = op;
+
+	/* the second opcode byte must come from the same page */
+	if( (pc & 0x3ff) == 0x3ff )
+		return;
+
+	switch( op )
+	{
+		case 0xcb: table = Z80cb; cycles = cc[Z80_TABLE_cb]; break;
+		case 0xdd: table = Z80dd; cycles = cc[Z80_TABLE_dd]; break;
+		case 0xed: table = Z80ed; cycles = cc[Z80_TABLE_ed]; break;
+		case 0xfd: table = Z80fd; cycles = cc[Z80_TABLE_fd]; break;
+		default: return;
+	}
+
+	d->prefix = op;
+	op = cpu_readop(pc + 1);
+	d->handler = table[op];
+	d->cycles += cycles[op];
+	d->length = 2;
+	d->op = op;
+}
+
+MAME_INLINE Z80_Decoded *icache_lookup(unsigned pc)
+{
+	unsigned slot = pc >> 10;
+	Z80_Decoded *d;
+
+	if( cpu_readmap[slot] != icache_tag[slot] )
+		icache_map(slot);
+
+	d = icache_slot[slot];
+	if( !d )
+		return NULL;
+
+	d += pc & 0x3ff;
+	if( !d->handler )
+		icache_decode(d, pc);
+	return d;
+}
+
+#ifdef Z80_PROFILE
+static void icache_profile(Z80_Decoded *d)
+{
+	switch( d->prefix )
+	{
+		case 0x00: PROFILE_OP(op,d->op); return;
+		case 0xcb: PROFILE_OP(cb,d->op); break;
+		case 0xdd: PROFILE_OP(dd,d->op); break;
+		case 0xed: PROFILE_OP(ed,d->op); break;
+		case 0xfd: PROFILE_OP(fd,d->op); break;
+	}
+	PROFILE_OP(op,d->prefix);
+}
+#define PROFILE_DECODED(d)	icache_profile(d)
+#else
+#define PROFILE_DECODED(d)
+#endif
+
+/* Throw away every decoded page, e.g. when the cycle tables change */
+static void icache_flush(void)
+{
+	int i;
+
+	if( icache_page )
+	{
+		for( i = 0; i < (icache_size >> 10); i++ )
+		{
+			if( icache_page[i] )
+				free(icache_page[i]);
+			icache_page[i] = NULL;
+		}
+	}
+
+	for( i = 0; i < 64; i++ )
+	{
+		icache_tag[i] = NULL;
+		icache_slot[i] = NULL;
+	}
+}
+#endif
+
+/****************************************************************************
+ * Set the ROM whose code may be cached, size is a multiple of 1K.
+ * Pass NULL to free the cache.
+ ****************************************************************************/
+#ifdef Z80_MSX
+void z80_msx_icache_init(unsigned char *rom, int size)
+#else
+void z80_icache_init(unsigned char *rom, int size)
+#endif
+{
+	Z80_FORWARD_VOID(icache_init,(rom, size));
+#if Z80_ICACHE
+	icache_flush();
+	if( icache_page )
+		free(icache_page);
+	icache_page = NULL;
+	icache_rom = NULL;
+	icache_size = 0;
+
+	if( !rom || size < 0x400 )
+		return;
+
+	icache_page = calloc(size >> 10, sizeof(Z80_Decoded *));
+	if( !icache_page )
+		return;
+
+	icache_rom = rom;
+	icache_size = size & ~0x3ff;
+#endif
+}
+
 /****************************************************************************
  * Processor initialization
  ****************************************************************************/
@@ -4011,6 +4891,7 @@ void z80_init(void)
 #endif
 {
 	int i, p;
+	Z80_FORWARD_VOID(init,());
 #if BIG_FLAGS_ARRAY
 	if( !SZHVC_add || !SZHVC_sub )
 	{
@@ -4079,6 +4960,12 @@ void z80_init(void)
 		}
 	}
 #endif
+	Z80_Context = &Z80;
+
+	/* flag tables are shared by all threads, build them once */
+	if( SZ[0] )
+		return;
+
 	for (i = 0; i < 256; i++)
 	{
 		p = 0;
@@ -4119,7 +5006,10 @@ void z80_msx_reset(void *param)
 void z80_reset(void *param)
 #endif
 {
+#if Z80_DAISY_CHAIN
 	Z80_DaisyChain *daisy_chain = (Z80_DaisyChain *)param;
+#endif
+	Z80_FORWARD_VOID(reset,(param));
 	memset(&Z80, 0, sizeof(Z80));
 	_IX = _IY = 0xffff; /* IX and IY are FFFF after a reset! */
 	_F = ZF;			/* Zero flag is set */
@@ -4127,7 +5017,9 @@ void z80_reset(void *param)
 	Z80.service_irq = -1;
 	Z80.nmi_state = CLEAR_LINE;
 	Z80.irq_state = CLEAR_LINE;
+	code_page = ~0U;
 
+#if Z80_DAISY_CHAIN
 	if( daisy_chain )
 	{
 		while( daisy_chain->irq_param != -1 && Z80.irq_max < Z80_MAXDAISY )
@@ -4141,6 +5033,7 @@ void z80_reset(void *param)
 			daisy_chain++;
 		}
 	}
+#endif
 
 	change_pc16(_PCD);
 }
@@ -4151,6 +5044,7 @@ void z80_msx_exit(void)
 void z80_exit(void)
 #endif
 {
+	Z80_FORWARD_VOID(exit,());
 #if BIG_FLAGS_ARRAY
 	if (SZHVC_add) free(SZHVC_add);
 	SZHVC_add = NULL;
@@ -4168,22 +5062,100 @@ int z80_msx_execute(int cycles)
 int z80_execute(int cycles)
 #endif
 {
+	int slice;
+
+	Z80_FORWARD(execute,(cycles));
 	Z80_ICOUNT = cycles - Z80.extra_cycles;
 	Z80.extra_cycles = 0;
+	slice = Z80_ICOUNT;
 
     z80_requested_cycles = Z80_ICOUNT;
     z80_exec = 1;
 
+#if IDLE_LOOP_HACKS
+	/* ports and interrupts may have changed between time slices */
+	idle_pc = -1;
+#endif
+
+#if Z80_THREADED
+	{
+		static const void *const op_label[256] = { THREAD_LABELS(op) };
+		static const void *const cb_label[256] = { THREAD_LABELS(cb) };
+		static const void *const dd_label[256] = { THREAD_LABELS(dd) };
+		static const void *const ed_label[256] = { THREAD_LABELS(ed) };
+		static const void *const fd_label[256] = { THREAD_LABELS(fd) };
+		static const void *const xycb_label[256] = { THREAD_LABELS(xycb) };
+#ifdef Z80_PROFILE
+		int icount;
+#endif
+
+		/* like the loop below, always run at least one instruction */
+		THREAD_FETCH;
+
+		THREAD_HANDLERS_OP(op)
+		THREAD_HANDLERS(cb)
+		THREAD_HANDLERS_XY(dd)
+		THREAD_HANDLERS(ed)
+		THREAD_HANDLERS_XY(fd)
+		THREAD_HANDLERS(xycb)
+
+		/* prefixes, as op_cb/op_dd/op_ed/op_fd and dd_cb/fd_cb */
+		op_cb_L: _R++; THREAD_DISPATCH(cb,ROP());
+		op_dd_L: _R++; THREAD_DISPATCH(dd,ROP());
+		op_ed_L: _R++; THREAD_DISPATCH(ed,ROP());
+		op_fd_L: _R++; THREAD_DISPATCH(fd,ROP());
+		dd_cb_L: _R++; EAX; THREAD_DISPATCH(xycb,ARG());
+		fd_cb_L: _R++; EAY; THREAD_DISPATCH(xycb,ARG());
+
+thread_done: ;
+	}
+#else
 	do
 	{
-		_PPC = _PCD;
-		_R++;
-		EXEC_INLINE(op,ROP());
+#if Z80_ICACHE
+		Z80_Decoded *d;
+#endif
+#ifdef Z80_PROFILE
+		int icount = Z80_ICOUNT;
+#endif
+		TRACK_PPC;
+#if Z80_ICACHE
+		d = icache_lookup(_PCD);
+		if( d && d->prefix )
+		{
+			_R += 2;
+			_PC += 2;
+			Z80_ICOUNT -= d->cycles;
+			PROFILE_DECODED(d);
+			(*d->handler)();
+		}
+		else
+		if( d )
+		{
+			/* plain opcodes are still best served by the big switch */
+			_R++;
+			_PC++;
+			EXEC_INLINE(op,d->op);
+		}
+		else
+#endif
+		{
+			_R++;
+			EXEC_INLINE(op,ROP());
+		}
+#ifdef Z80_PROFILE
+		if( z80_profile_insn )
+			(*z80_profile_insn)(_PPC, icount - Z80_ICOUNT);
+#endif
 	} while( Z80_ICOUNT > 0 );
+#endif
 
 	Z80_ICOUNT -= Z80.extra_cycles;
 	Z80.extra_cycles = 0;
 
+	/* z80_end_slice() takes the cycles it cut off the request */
+	cycles -= slice - z80_requested_cycles;
+
     // add cycles executed to running total
     z80_exec = 0;
     z80_cycle_count += (cycles - Z80_ICOUNT);
@@ -4200,6 +5172,7 @@ void z80_msx_burn(int cycles)
 void z80_burn(int cycles)
 #endif
 {
+	Z80_FORWARD_VOID(burn,(cycles));
 	if( cycles > 0 )
 	{
 		/* NOP takes 4 cycles per instruction */
@@ -4218,6 +5191,7 @@ unsigned z80_msx_get_context (void *dst)
 unsigned z80_get_context (void *dst)
 #endif
 {
+	Z80_FORWARD(get_context,(dst));
 	if( dst )
 		*(Z80_Regs*)dst = Z80;
 	return sizeof(Z80_Regs);
@@ -4232,11 +5206,27 @@ void z80_msx_set_context (void *src)
 void z80_set_context (void *src)
 #endif
 {
+	Z80_FORWARD_VOID(set_context,(src));
 	if( src )
 		Z80 = *(Z80_Regs*)src;
+	code_page = ~0U;
 	change_pc16(_PCD);
 }
 
+/****************************************************************************
+ * Called whenever cpu_readmap[] changes, so code is no longer read from
+ * the page that was mapped before
+ ****************************************************************************/
+#ifdef Z80_MSX
+void z80_msx_remap (void)
+#else
+void z80_remap (void)
+#endif
+{
+	Z80_FORWARD_VOID(remap,());
+	code_page = ~0U;
+}
+
 /****************************************************************************
  * Get a pointer to a cycle count table
  ****************************************************************************/
@@ -4246,6 +5236,7 @@ const void *z80_msx_get_cycle_table (int which)
 const void *z80_get_cycle_table (int which)
 #endif
 {
+	Z80_FORWARD(get_cycle_table,(which));
 	if (which >= 0 && which <= Z80_TABLE_xycb)
 		return cc[which];
 	return NULL;
@@ -4260,8 +5251,13 @@ void z80_msx_set_cycle_table (int which, void *new_table)
 void z80_set_cycle_table (int which, void *new_table)
 #endif
 {
+	Z80_FORWARD_VOID(set_cycle_table,(which, new_table));
 	if (which >= 0 && which <= Z80_TABLE_ex)
 		cc[which] = new_table;
+#if Z80_ICACHE
+	/* decoded instructions hold their cycle counts */
+	icache_flush();
+#endif
 }
 
 /****************************************************************************
@@ -4273,6 +5269,7 @@ unsigned z80_msx_get_reg (int regnum)
 unsigned z80_get_reg (int regnum)
 #endif
 {
+	Z80_FORWARD(get_reg,(regnum));
 	switch( regnum )
 	{
 		case REG_PC: return _PCD;
@@ -4322,6 +5319,7 @@ void z80_msx_set_reg (int regnum, unsigned val)
 void z80_set_reg (int regnum, unsigned val)
 #endif
 {
+	Z80_FORWARD_VOID(set_reg,(regnum, val));
 	switch( regnum )
 	{
 		case REG_PC: _PC = val; change_pc16(_PCD); break;
@@ -4377,6 +5375,7 @@ void z80_msx_set_irq_line(int irqline, int state)
 void z80_set_irq_line(int irqline, int state)
 #endif
 {
+	Z80_FORWARD_VOID(set_irq_line,(irqline, state));
 	if (irqline == IRQ_LINE_NMI)
 	{
 		if( Z80.nmi_state == state ) return;
@@ -4392,6 +5391,7 @@ void z80_set_irq_line(int irqline, int state)
 		_IFF1 = 0;
 		PUSH( PC );
 		_PCD = 0x0066;
+		PROFILE_CALL(_PCD);
 		Z80.extra_cycles += 11;
 	}
 	else
@@ -4400,6 +5400,7 @@ void z80_set_irq_line(int irqline, int state)
 		Z80.irq_state = state;
 		if( state == CLEAR_LINE ) return;
 
+#if Z80_DAISY_CHAIN
 		if( Z80.irq_max )
 		{
 			int daisychain, device, int_state;
@@ -4438,6 +5439,7 @@ void z80_set_irq_line(int irqline, int state)
 				return;
 			}
 		}
+#endif
 		take_interrupt();
 	}
 }
@@ -4451,11 +5453,13 @@ void z80_msx_set_irq_callback(int (*callback)(int))
 void z80_set_irq_callback(int (*callback)(int))
 #endif
 {
+	Z80_FORWARD_VOID(set_irq_callback,(callback));
     LOG(("Z80 #%d set_irq_callback $%08x\n",0 , (int)callback));
 	Z80.irq_callback = callback;
 }
 
 
+#ifndef Z80_CORE
 void z80_reset_cycle_count(void)
 {
     z80_cycle_count = 0;
@@ -4473,3 +5477,74 @@ int z80_get_elapsed_cycles(void)
     return z80_cycle_count;
 }
 
+/* End the running time slice 'cycles' from now, if it would run longer */
+void z80_end_slice(int cycles)
+{
+    if(z80_exec == 1 && z80_ICount > cycles)
+    {
+        z80_requested_cycles -= z80_ICount - cycles;
+        z80_ICount = cycles;
+    }
+}
+
+#endif
+
+#ifdef Z80_CORE
+/****************************************************************************
+ * Entry points of this variant, see z80_select_core()
+ ****************************************************************************/
+const z80_core_t Z80_CORE_FN(core) =
+{
+	Z80_CORE_STR(Z80_CORE),
+	z80_init,
+	z80_reset,
+	z80_exit,
+	z80_execute,
+	z80_burn,
+	z80_get_context,
+	z80_set_context,
+	z80_remap,
+	z80_get_cycle_table,
+	z80_set_cycle_table,
+	z80_get_reg,
+	z80_set_reg,
+	z80_set_irq_line,
+	z80_set_irq_callback,
+	z80_icache_init
+};
+#elif defined(Z80_CORES)
+/****************************************************************************
+ * Choose the build of the core this thread runs: "exact" with no speed
+ * hacks, "fast" without Z80_EXACT, "lean" without daisy chain and
+ * previous PC support, or "default" for this one. Call it before
+ * z80_init(); returns zero if the name isn't known
+ ****************************************************************************/
+static const z80_core_t *const z80_cores[] =
+{
+	&z80_exact_core,
+	&z80_fast_core,
+	&z80_lean_core,
+	NULL
+};
+
+int z80_select_core(const char *name)
+{
+	int i;
+
+	if( !name || !strcmp(name, "default") )
+	{
+		z80_core = NULL;
+		return 1;
+	}
+
+	for( i = 0; z80_cores[i]; i++ )
+	{
+		if( !strcmp(name, z80_cores[i]->name) )
+		{
+			z80_core = z80_cores[i];
+			return 1;
+		}
+	}
+	return 0;
+}
+#endif
@@ -20,6 +20,24 @@ enum {
 	Z80_TABLE_ex	/* cycles counts for taken jr/jp/call and interrupt latency (rst opcodes) */
 };
 
+/* What a write to each 1K page does (cpu_writeattr[]) */
+enum {
+	Z80_PAGE_HANDLER,	/* passed to cpu_writemem16, the default */
+	Z80_PAGE_RAM,		/* stored to cpu_writemap[] */
+	Z80_PAGE_ROM		/* dropped */
+};
+
+/* Opcode tables counted when built with Z80_PROFILE */
+enum {
+	Z80_PROF_op,
+	Z80_PROF_cb,
+	Z80_PROF_dd,
+	Z80_PROF_ed,
+	Z80_PROF_fd,
+	Z80_PROF_xycb,
+	Z80_PROF_MAX
+};
+
 /****************************************************************************/
 /* The Z80 registers. HALT is set to 1 when the CPU is halted, the refresh	*/
 /* register is calculated as follows: refresh=(Regs.R&127)|(Regs.R2&128)	*/
@@ -40,7 +58,7 @@ typedef struct {
 }	Z80_Regs;
 
 
-extern int z80_ICount;              /* T-state count                        */
+extern THREAD_LOCAL int z80_ICount;             /* T-state count                        */
 
 extern void z80_init(void);
 extern void z80_reset (void *param);
@@ -56,18 +74,63 @@ extern void z80_set_reg (int regnum, unsigned val);
 extern void z80_set_irq_line(int irqline, int state);
 extern void z80_set_irq_callback(int (*irq_callback)(int));
 extern unsigned z80_dasm(char *buffer, unsigned pc);
+extern void z80_icache_init(unsigned char *rom, int size);
+extern void z80_remap(void);
 
-extern Z80_Regs *Z80_Context;
-extern int after_EI;
-extern unsigned char *cpu_readmap[64];
-extern unsigned char *cpu_writemap[64];
+extern THREAD_LOCAL Z80_Regs *Z80_Context;
+extern THREAD_LOCAL int after_EI;
+extern THREAD_LOCAL unsigned char *cpu_readmap[64];
+extern THREAD_LOCAL unsigned char *cpu_writemap[64];
+extern THREAD_LOCAL unsigned char cpu_writeattr[64];
 
-void (*cpu_writemem16)(int address, int data);
-void (*cpu_writeport16)(uint16 port, uint8 data);
-uint8 (*cpu_readport16)(uint16 port);
+extern THREAD_LOCAL void (*cpu_writemem16)(int address, int data);
+extern THREAD_LOCAL void (*cpu_writeport16)(uint16 port, uint8 data);
+extern THREAD_LOCAL uint8 (*cpu_readport16)(uint16 port);
+extern THREAD_LOCAL int (*cpu_idleport16)(uint16 port);
+extern THREAD_LOCAL int (*cpu_idlepc16)(uint16 pc);
+extern THREAD_LOCAL int (*cpu_writeblock16)(uint16 port, const uint8 *src, int len);
+extern THREAD_LOCAL int (*cpu_readblock16)(uint16 port, uint8 *dst, int len);
+
+#ifdef Z80_PROFILE
+extern THREAD_LOCAL int z80_exec;
+extern THREAD_LOCAL UINT32 z80_op_count[Z80_PROF_MAX][256];
+extern THREAD_LOCAL void (*z80_profile_insn)(int pc, int cycles);
+extern THREAD_LOCAL void (*z80_profile_call)(int pc, int target);
+extern THREAD_LOCAL void (*z80_profile_ret)(int sp);
+#endif
 
 void z80_reset_cycle_count(void);
 int z80_get_elapsed_cycles(void);
+void z80_end_slice(int cycles);
+
+#ifdef Z80_CORES
+/* A build of the core with its own options, see z80_select_core() */
+typedef struct {
+	const char *name;
+	void (*init)(void);
+	void (*reset)(void *param);
+	void (*exit)(void);
+	int (*execute)(int cycles);
+	void (*burn)(int cycles);
+	unsigned (*get_context)(void *dst);
+	void (*set_context)(void *src);
+	void (*remap)(void);
+	const void *(*get_cycle_table)(int which);
+	void (*set_cycle_table)(int which, void *new_tbl);
+	unsigned (*get_reg)(int regnum);
+	void (*set_reg)(int regnum, unsigned val);
+	void (*set_irq_line)(int irqline, int state);
+	void (*set_irq_callback)(int (*irq_callback)(int));
+	void (*icache_init)(unsigned char *rom, int size);
+}	z80_core_t;
+
+extern THREAD_LOCAL const z80_core_t *z80_core;
+extern const z80_core_t z80_exact_core;
+extern const z80_core_t z80_fast_core;
+extern const z80_core_t z80_lean_core;
+
+extern int z80_select_core(const char *name);
+#endif
 
 #endif
 
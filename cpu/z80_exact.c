@@ -0,0 +1,13 @@
+/*
+    z80_exact.c --
+    Z80 core with none of the speed hacks, for accuracy runs.
+*/
+
+#define Z80_CORE		exact
+
+#define BUSY_LOOP_HACKS 0
+#define TIME_LOOP_HACKS 0
+#define IDLE_LOOP_HACKS 0
+#define BLOCK_IO_HACKS	0
+
+#include "z80.c"
@@ -0,0 +1,11 @@
+/*
+    z80_fast.c --
+    Z80 core that leaves the undocumented X and Y flags alone where
+    it can, with every speed hack, for throughput runs.
+*/
+
+#define Z80_CORE		fast
+
+#define Z80_EXACT		0
+
+#include "z80.c"
@@ -0,0 +1,12 @@
+/*
+    z80_lean.c --
+    Z80 core for the SMS and GG only: no daisy chained interrupt
+    devices, and the previous PC is not kept unless profiling.
+*/
+
+#define Z80_CORE		lean
+
+#define Z80_DAISY_CHAIN 0
+#define Z80_TRACK_PPC	0
+
+#include "z80.c"
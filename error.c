@@ -6,7 +6,7 @@
 #include "shared.h"
 
 #ifdef DEBUG
-static FILE *error_log;
+static THREAD_LOCAL FILE *error_log;
 #endif
 
 struct {
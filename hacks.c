@@ -0,0 +1,278 @@
+/*
+    hacks.c --
+    Per-game speed hack database.
+
+    Each line of the database holds '<crc> <type> <pc> <bank>' in hex, where
+    the bank is the 16K ROM page mapped in at the PC. A 'clock' entry gives
+    the game hidden lines of Z80 time each frame instead, their count in
+    the PC field and 00 as the bank. Lines starting with '#' and types this
+    version doesn't know are skipped. The database is shared by all
+    instances and should be loaded before any is created.
+*/
+#include "shared.h"
+
+static const char *type_name[HACK_TYPES] = {
+    "idle",
+    "clock",
+};
+
+/* Loaded database */
+static hack_t *db = NULL;
+static int db_count = 0;
+
+/* Hacks for the game running on this thread */
+static THREAD_LOCAL hack_t active[HACK_MAX];
+static THREAD_LOCAL int active_count = 0;
+
+
+static int hack_parse(char *line, hack_t *h)
+{
+    char name[0x10];
+    unsigned int crc, pc, bank;
+    int i;
+
+    if(line[0] == '#')
+        return 0;
+
+    if(sscanf(line, "%x %15s %x %x", &crc, name, &pc, &bank) != 4)
+        return 0;
+
+    for(i = 0; i < HACK_TYPES; i++)
+    {
+        if(strcmp(name, type_name[i]) == 0)
+        {
+            h->crc = crc;
+            h->type = i;
+            h->pc = pc & 0xFFFF;
+            h->bank = bank & 0xFF;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+/* Load a database, replacing the current one. Returns the entry count */
+int hacks_load(char *filename)
+{
+    char line[0x100];
+    int size = 0;
+    FILE *fd;
+
+    hacks_free();
+
+    fd = fopen(filename, "r");
+    if(!fd)
+        return 0;
+
+    while(fgets(line, sizeof(line), fd))
+    {
+        hack_t h;
+
+        if(!hack_parse(line, &h))
+            continue;
+
+        if(db_count == size)
+        {
+            hack_t *p;
+            size = size ? size * 2 : 64;
+            p = realloc(db, size * sizeof(hack_t));
+            if(!p)
+                break;
+            db = p;
+        }
+
+        db[db_count++] = h;
+    }
+
+    fclose(fd);
+    return db_count;
+}
+
+
+void hacks_free(void)
+{
+    if(db)
+        free(db);
+    db = NULL;
+    db_count = 0;
+}
+
+
+/*
+    Write the active hacks as the game's idle entries for 'crc', keeping its
+    other entries and the other games' lines of the file as they are.
+*/
+int hacks_save(char *filename, uint32 crc, char *name)
+{
+    char line[0x100];
+    char **keep = NULL;
+    hack_t other[HACK_MAX];
+    int count = 0, size = 0, others = 0, i;
+    FILE *fd;
+
+    fd = fopen(filename, "r");
+    if(fd)
+    {
+        while(fgets(line, sizeof(line), fd))
+        {
+            hack_t h;
+            char *end;
+
+            /* Drop the game's entries and the comment naming it */
+            if(hack_parse(line, &h) && h.crc == crc)
+            {
+                /* Only idle entries are found by smsdiscover */
+                if(h.type != HACK_IDLE && others < HACK_MAX)
+                    other[others++] = h;
+                continue;
+            }
+            if(line[0] == '#' && strtoul(line + 1, &end, 16) == crc && end == line + 10)
+                continue;
+
+            if(count == size)
+            {
+                char **p;
+                size = size ? size * 2 : 64;
+                p = realloc(keep, size * sizeof(char *));
+                if(!p)
+                    break;
+                keep = p;
+            }
+            keep[count] = malloc(strlen(line) + 1);
+            if(keep[count])
+                strcpy(keep[count++], line);
+        }
+        fclose(fd);
+    }
+
+    fd = fopen(filename, "w");
+    if(fd)
+    {
+        if(count == 0)
+            fprintf(fd, "# crc      type pc   bank\n");
+
+        for(i = 0; i < count; i++)
+            fputs(keep[i], fd);
+
+        if(active_count || others)
+            fprintf(fd, "# %08X %s\n", crc, name ? name : "");
+
+        for(i = 0; i < others; i++)
+        {
+            fprintf(fd, "%08X %-4s %04X %02X\n", crc,
+                type_name[other[i].type], other[i].pc, other[i].bank);
+        }
+
+        for(i = 0; i < active_count; i++)
+        {
+            if(active[i].type != HACK_IDLE)
+                continue;
+            fprintf(fd, "%08X %-4s %04X %02X\n", crc,
+                type_name[active[i].type], active[i].pc, active[i].bank);
+        }
+
+        fclose(fd);
+    }
+
+    for(i = 0; i < count; i++)
+        free(keep[i]);
+    free(keep);
+
+    return (fd != NULL);
+}
+
+
+/* Bank of the code at 'pc' with the current mapping */
+int hacks_bank(int pc)
+{
+    uint8 *p = cpu_readmap[(pc >> 10) & 0x3F];
+
+    if(cart.rom && p >= cart.rom && p < cart.rom + cart.pages * 0x4000)
+        return ((p - cart.rom) >> 14) & 0xFF;
+
+    return HACK_BANK_RAM;
+}
+
+
+/* Called by the Z80 core on taken backward branches */
+static int hack_idle(uint16 pc)
+{
+    int i;
+
+    for(i = 0; i < active_count; i++)
+    {
+        if(active[i].type == HACK_IDLE && active[i].pc == pc &&
+           active[i].bank == hacks_bank(pc))
+            return 1;
+    }
+
+    return 0;
+}
+
+
+/* Turn on the database entries for a game */
+void hacks_apply(uint32 crc)
+{
+    int i;
+
+    hacks_clear();
+
+    for(i = 0; i < db_count; i++)
+    {
+        if(db[i].crc == crc)
+            hacks_add(db[i].type, db[i].pc, db[i].bank);
+    }
+}
+
+
+void hacks_clear(void)
+{
+    active_count = 0;
+    cpu_idlepc16 = NULL;
+    system_overclock(0);
+}
+
+
+/* Turn off the active hacks of one type and leave the others on */
+void hacks_remove(int type)
+{
+    int i, n = 0;
+
+    for(i = 0; i < active_count; i++)
+    {
+        if(active[i].type != type)
+            active[n++] = active[i];
+    }
+    active_count = n;
+
+    if(type == HACK_IDLE)
+        cpu_idlepc16 = NULL;
+    else
+    if(type == HACK_CLOCK)
+        system_overclock(0);
+}
+
+
+int hacks_add(int type, int pc, int bank)
+{
+    hack_t *h;
+
+    if(active_count == HACK_MAX || type < 0 || type >= HACK_TYPES)
+        return 0;
+
+    h = &active[active_count++];
+    h->crc = cart.crc;
+    h->type = type;
+    h->pc = pc & 0xFFFF;
+    h->bank = bank & 0xFF;
+
+    if(type == HACK_IDLE)
+        cpu_idlepc16 = hack_idle;
+    else
+    if(type == HACK_CLOCK)
+        system_overclock(h->pc);
+
+    return 1;
+}
@@ -0,0 +1,42 @@
+#ifndef _HACKS_H_
+#define _HACKS_H_
+
+/*
+    Per-game speed hacks. A database keyed by cart.crc lists shortcuts that
+    were checked not to change a game's video or audio output (see the
+    smsdiscover tool), and overclocks for games that slow down when busy;
+    sms_init() turns on the ones for the loaded game.
+*/
+
+/* Hack types */
+enum {
+    HACK_IDLE = 0,          /* Branch closing a loop that waits for the slice to end */
+    HACK_CLOCK,             /* Overclock, 'pc' holds the hidden lines per frame */
+    HACK_TYPES
+};
+
+/* Bank of code running outside the cartridge ROM */
+#define HACK_BANK_RAM   0xFF
+
+/* Hacks active at once */
+#define HACK_MAX        16
+
+typedef struct
+{
+    uint32 crc;
+    int type;
+    int pc;
+    int bank;
+} hack_t;
+
+/* Function prototypes */
+int hacks_load(char *filename);
+void hacks_free(void);
+int hacks_save(char *filename, uint32 crc, char *name);
+void hacks_apply(uint32 crc);
+void hacks_clear(void);
+void hacks_remove(int type);
+int hacks_add(int type, int pc, int bank);
+int hacks_bank(int pc);
+
+#endif /* _HACKS_H_ */
@@ -0,0 +1,163 @@
+/*
+    instance.c --
+    Emulator instances.
+
+    All console state (sms, vdp, cart, bitmap, input, snd, the Z80 register
+    file and memory map, the pattern cache and the sound chip contexts) is
+    declared THREAD_LOCAL, so every host thread owns one complete console.
+    An instance bundles that state with the memory it needs and may only be
+    driven from the thread that created it; read-only look-up tables are
+    built once and shared by all instances.
+*/
+#include "shared.h"
+
+#ifdef LINUX
+#include <pthread.h>
+
+/* Serializes ROM loading and table generation */
+static pthread_mutex_t instance_lock = PTHREAD_MUTEX_INITIALIZER;
+#define LOCK()      pthread_mutex_lock(&instance_lock)
+#define UNLOCK()    pthread_mutex_unlock(&instance_lock)
+#else
+#define LOCK()
+#define UNLOCK()
+#endif
+
+/* Instance owned by this thread */
+static THREAD_LOCAL instance_t *current = NULL;
+
+
+/* Load a game and power on a new console owned by the calling thread */
+instance_t *instance_create(char *filename, instance_config_t *config)
+{
+    instance_t *inst;
+    int depth = (config->depth == 16) ? 16 : 8;
+
+    /* One console per thread */
+    if(current)
+        return NULL;
+
+#ifdef Z80_CORES
+    /* Chosen per thread, before the core is set up */
+    if(!z80_select_core(config->core))
+        return NULL;
+#endif
+
+    /* load_rom() keys off the file extension */
+    if(strlen(filename) >= PATH_MAX || !strrchr(filename, '.'))
+        return NULL;
+
+    inst = calloc(1, sizeof(instance_t));
+    if(!inst)
+        return NULL;
+
+    inst->config = *config;
+    inst->config.depth = depth;
+    inst->bmp = calloc(256 * 256, depth >> 3);
+    if(!inst->bmp)
+    {
+        free(inst);
+        return NULL;
+    }
+
+    LOCK();
+
+    strcpy(game_name, filename);
+
+    if(load_rom(game_name) == 0)
+    {
+        UNLOCK();
+        free(inst->bmp);
+        free(inst);
+        return NULL;
+    }
+
+    /* Force Codemasters mapper */
+    if(config->codies)
+    {
+        cart.mapper = MAPPER_CODIES;
+        sms.territory = TERRITORY_EXPORT;
+    }
+
+    /* Override the console picked from the file extension */
+    if(config->console)
+        sms.console = config->console;
+
+    /* Set up bitmap structure */
+    memset(&bitmap, 0, sizeof(bitmap_t));
+    bitmap.width  = 256;
+    bitmap.height = 256;
+    bitmap.depth  = depth;
+    bitmap.granularity = (bitmap.depth >> 3);
+    bitmap.pitch  = bitmap.width * bitmap.granularity;
+    bitmap.data   = inst->bmp;
+    bitmap.viewport.x = 0;
+    bitmap.viewport.y = 0;
+    bitmap.viewport.w = 256;
+    bitmap.viewport.h = 192;
+
+    snd.fm_which = SND_EMU2413;
+    snd.fps = (sms.display == DISPLAY_NTSC) ? FPS_NTSC : FPS_PAL;
+    snd.fm_clock = (sms.display == DISPLAY_NTSC) ? CLOCK_NTSC : CLOCK_PAL;
+    snd.psg_clock = (sms.display == DISPLAY_NTSC) ? CLOCK_NTSC : CLOCK_PAL;
+    snd.sample_rate = config->sample_rate;
+    snd.mixer_callback = NULL;
+
+    /* sms_init() picks the SMS (J) console when FM sound is enabled */
+    sms.use_fm = config->use_fm;
+
+    /* Initialize the virtual console emulation */
+    system_init();
+    sms.territory = config->territory;
+
+    /* Overrides the speed hack database */
+    if(config->overclock)
+        system_overclock(config->overclock);
+
+    UNLOCK();
+
+    system_poweron();
+
+    current = inst;
+    return inst;
+}
+
+
+/* Power off and release an instance, from the thread that created it */
+void instance_destroy(instance_t *inst)
+{
+    if(!inst || inst != current)
+        return;
+
+    system_poweroff();
+    system_shutdown();
+
+    if(cart.rom)
+    {
+        free(cart.rom);
+        cart.rom = NULL;
+    }
+
+    memset(&bitmap, 0, sizeof(bitmap_t));
+    free(inst->bmp);
+    free(inst);
+    current = NULL;
+}
+
+
+/* Run one frame, returns 0 if called from the wrong thread */
+int instance_frame(instance_t *inst, int skip_render)
+{
+    if(inst != current)
+        return 0;
+
+    system_frame(skip_render);
+    inst->frame_count++;
+    return 1;
+}
+
+
+instance_t *instance_current(void)
+{
+    return current;
+}
@@ -0,0 +1,32 @@
+
+#ifndef _INSTANCE_H_
+#define _INSTANCE_H_
+
+/* Instance configuration */
+typedef struct
+{
+    int depth;              /* Bitmap depth (8, 16) */
+    int sample_rate;        /* Sound sample rate, 0 disables sound */
+    int use_fm;             /* Enable YM2413 sound */
+    int territory;          /* TERRITORY_EXPORT or TERRITORY_DOMESTIC */
+    int codies;             /* Force Codemasters mapper */
+    int console;            /* CONSOLE_*, 0 for the one the file extension picks */
+    int overclock;          /* Hidden lines per frame, 0 for the game's setting */
+    char *core;             /* Z80 core build (Z80_CORES), NULL for the default */
+} instance_config_t;
+
+/* Emulator instance */
+typedef struct
+{
+    instance_config_t config;
+    uint8 *bmp;             /* Display memory */
+    uint32 frame_count;     /* Frames run since power-on */
+} instance_t;
+
+/* Function prototypes */
+instance_t *instance_create(char *filename, instance_config_t *config);
+void instance_destroy(instance_t *inst);
+int instance_frame(instance_t *inst, int skip_render);
+instance_t *instance_current(void);
+
+#endif /* _INSTANCE_H_ */
@@ -0,0 +1,481 @@
+/*
+    batch.c --
+    Parallel batch runner for ROM corpora.
+
+    Jobs are run in worker processes, so a game that crashes the core
+    only takes its own job down. Each worker starts with a contiguous
+    slice of the job list in its own deque, pops work from the bottom and
+    steals from the top of the other deques once its own runs dry.
+*/
+
+#include "osd.h"
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define OUTPUT_HASH     0x01
+#define OUTPUT_SNAP     0x02
+#define OUTPUT_WAV      0x04
+
+#define JOB_PENDING     0
+#define JOB_RUNNING     1
+#define JOB_DONE        2
+#define JOB_FAILED      3
+
+typedef struct
+{
+    char rom[PATH_MAX];
+    char script[PATH_MAX];
+    int frames;
+    int outputs;
+} t_job;
+
+/* Job results, written by the workers into shared memory */
+typedef struct
+{
+    int status;
+    int worker;
+    double elapsed;
+    uint32 video;
+    uint32 audio;
+} t_result;
+
+/* Range of job indices owned by one worker */
+typedef struct
+{
+    int lock;
+    int top;
+    int bottom;
+    int steals;
+    double busy;
+} t_deque;
+
+static t_job *job;
+static int job_count;
+static char *out_dir = ".";
+
+static t_result *result;
+static t_deque *deque;
+static int worker_count;
+
+
+static void deque_lock(t_deque *d)
+{
+    while(__atomic_exchange_n(&d->lock, 1, __ATOMIC_ACQUIRE))
+    {
+        while(__atomic_load_n(&d->lock, __ATOMIC_RELAXED))
+            ;
+    }
+}
+
+
+static void deque_unlock(t_deque *d)
+{
+    __atomic_store_n(&d->lock, 0, __ATOMIC_RELEASE);
+}
+
+
+/* Owner side: take the most recently queued job */
+static int deque_pop(t_deque *d)
+{
+    int index = -1;
+
+    deque_lock(d);
+    if(d->top < d->bottom)
+        index = --d->bottom;
+    deque_unlock(d);
+
+    return index;
+}
+
+
+/* Thief side: take the oldest job */
+static int deque_steal(t_deque *d)
+{
+    int index = -1;
+
+    deque_lock(d);
+    if(d->top < d->bottom)
+        index = d->top++;
+    deque_unlock(d);
+
+    return index;
+}
+
+
+/* Find the next job for a worker, stealing when its own deque is empty */
+static int next_job(int w)
+{
+    int i, index;
+
+    index = deque_pop(&deque[w]);
+    if(index >= 0)
+        return index;
+
+    for(i = 1; i < worker_count; i++)
+    {
+        index = deque_steal(&deque[(w + i) % worker_count]);
+        if(index >= 0)
+        {
+            deque[w].steals++;
+            return index;
+        }
+    }
+
+    return -1;
+}
+
+
+/* Output file name derived from the ROM name and job index */
+static void output_name(char *buf, int index, char *ext)
+{
+    char *base = strrchr(job[index].rom, '/');
+    base = base ? base + 1 : job[index].rom;
+    snprintf(buf, PATH_MAX * 2, "%s/%s.%d.%s", out_dir, base, index, ext);
+}
+
+
+static int run_job(int index)
+{
+    t_job *j = &job[index];
+    t_result *r = &result[index];
+    instance_config_t config;
+    instance_t *inst;
+    t_input_script script;
+    t_wav wav;
+    char name[PATH_MAX * 2];
+    uint32 video = 0, audio = 0;
+    double start;
+    int i;
+
+    if(!script_load(&script, j->script))
+        return 0;
+
+    headless_config(&config);
+    inst = instance_create(j->rom, &config);
+    if(!inst)
+    {
+        script_free(&script);
+        return 0;
+    }
+
+    memset(&wav, 0, sizeof(t_wav));
+    if(j->outputs & OUTPUT_WAV)
+    {
+        output_name(name, index, "wav");
+        wav_open(&wav, name);
+    }
+
+    start = headless_time();
+
+    for(i = 0; i < j->frames; i++)
+    {
+        script_apply(&script, i);
+        instance_frame(inst, option.render ? 0 : 1);
+
+        if(j->outputs & OUTPUT_HASH)
+        {
+            video = video_crc(video);
+            audio = audio_crc(audio);
+        }
+
+        wav_update(&wav);
+    }
+
+    r->elapsed = headless_time() - start;
+    r->video = video;
+    r->audio = audio;
+
+    if(j->outputs & OUTPUT_SNAP)
+    {
+        output_name(name, index, "ppm");
+        snap_save(name);
+    }
+
+    wav_close(&wav);
+    instance_destroy(inst);
+    script_free(&script);
+    return 1;
+}
+
+
+static void worker(int w)
+{
+    int index;
+
+    while((index = next_job(w)) >= 0)
+    {
+        result[index].worker = w;
+        __atomic_store_n(&result[index].status, JOB_RUNNING, __ATOMIC_RELEASE);
+
+        if(run_job(index))
+        {
+            deque[w].busy += result[index].elapsed;
+            __atomic_store_n(&result[index].status, JOB_DONE, __ATOMIC_RELEASE);
+        }
+        else
+            __atomic_store_n(&result[index].status, JOB_FAILED, __ATOMIC_RELEASE);
+    }
+
+    exit(0);
+}
+
+
+static pid_t spawn_worker(int w)
+{
+    pid_t pid = fork();
+    if(pid == 0)
+        worker(w);
+    return pid;
+}
+
+
+/*
+    Each line holds '<rom> <frames> [<script> [<outputs>]]', where outputs
+    is a comma separated list of 'hash', 'snap' and 'wav'. Use '-' to
+    leave the script or outputs out.
+*/
+static int load_jobs(char *filename)
+{
+    char line[PATH_MAX * 3];
+    int size = 0;
+    FILE *fd = fopen(filename, "r");
+
+    if(!fd)
+        return 0;
+
+    while(fgets(line, sizeof(line), fd))
+    {
+        char rom[PATH_MAX], script[PATH_MAX], outputs[0x100];
+        int frames, n;
+        t_job *j;
+
+        if(line[0] == '#')
+            continue;
+
+        strcpy(script, "-");
+        strcpy(outputs, "hash");
+
+        n = sscanf(line, "%4095s %d %4095s %255s", rom, &frames, script, outputs);
+        if(n < 2)
+            continue;
+
+        if(job_count == size)
+        {
+            size = size ? size * 2 : 64;
+            job = realloc(job, size * sizeof(t_job));
+            if(!job)
+                return 0;
+        }
+
+        j = &job[job_count++];
+        memset(j, 0, sizeof(t_job));
+        strcpy(j->rom, rom);
+        strcpy(j->script, script);
+        j->frames = (frames > 0) ? frames : 1;
+
+        if(strstr(outputs, "hash")) j->outputs |= OUTPUT_HASH;
+        if(strstr(outputs, "snap")) j->outputs |= OUTPUT_SNAP;
+        if(strstr(outputs, "wav"))  j->outputs |= OUTPUT_WAV;
+    }
+
+    fclose(fd);
+    return 1;
+}
+
+
+static void report(double wall)
+{
+    static const char *status_name[] = { "pending", "running", "ok", "FAILED" };
+    double busy = 0.0;
+    int i, done = 0, steals = 0;
+    double frames = 0.0;
+
+    printf("%-4s %-32s %8s %10s %10s %6s  %-8s %s\n",
+        "job", "rom", "frames", "fps", "ns/frame", "worker", "video", "audio");
+
+    for(i = 0; i < job_count; i++)
+    {
+        t_result *r = &result[i];
+        char *base = strrchr(job[i].rom, '/');
+        base = base ? base + 1 : job[i].rom;
+
+        if(r->status == JOB_DONE)
+        {
+            done++;
+            frames += job[i].frames;
+            printf("%-4d %-32.32s %8d %10.1f %10.0f %6d  ",
+                i, base, job[i].frames,
+                job[i].frames / r->elapsed,
+                r->elapsed * 1e9 / job[i].frames,
+                r->worker);
+
+            if(job[i].outputs & OUTPUT_HASH)
+                printf("%08X %08X\n", r->video, r->audio);
+            else
+                printf("-        -\n");
+        }
+        else
+            printf("%-4d %-32.32s %8d %10s %10s %6d  %s\n",
+                i, base, job[i].frames, "-", "-", r->worker, status_name[r->status]);
+    }
+
+    for(i = 0; i < worker_count; i++)
+    {
+        busy += deque[i].busy;
+        steals += deque[i].steals;
+    }
+
+    printf("\n");
+    printf("jobs:        %d ok, %d failed\n", done, job_count - done);
+    printf("workers:     %d\n", worker_count);
+    printf("wall time:   %.3f s\n", wall);
+    printf("busy time:   %.3f s\n", busy);
+    printf("utilisation: %.1f%%\n", wall > 0.0 ? 100.0 * busy / (worker_count * wall) : 0.0);
+    printf("steals:      %d\n", steals);
+    printf("throughput:  %.1f frames/s\n", wall > 0.0 ? frames / wall : 0.0);
+}
+
+
+int main(int argc, char **argv)
+{
+    pid_t *pid;
+    double start;
+    int i, n, running;
+
+    /* Show usage if no arguments are specified */
+    if(argc < 2)
+    {
+        printf("\n%s batch runner\n", APP_NAME);
+        printf("Version %s, build date: %s, %s\n", APP_VERSION, __DATE__, __TIME__);
+        printf("Usage: smsbatch <jobfile> [-options]\n");
+        printf("Job file lines: <rom> <frames> [<script>|- [hash,snap,wav]]\n");
+        printf("Options:\n");
+        printf(" -j <n>       \t number of worker processes. (default: all cores)\n");
+        printf(" -o <dir>     \t directory for snapshots and audio. (default: .)\n");
+        printf(" -norender    \t skip rendering.\n");
+        printf(" -nosound     \t disable sound emulation.\n");
+        printf(" -sndrate <n> \t specify sound rate. (8000-48000)\n");
+        printf(" -depth <n>   \t specify color depth. (8, 16)\n");
+        printf(" -fm          \t enable YM2413 sound.\n");
+        printf(" -jp          \t use Japanese console type.\n");
+        printf(" -codies      \t force Codemasters mapper.\n");
+        printf(" -console <name>\t sms, smsj, sms2, gg, ggms, md, mdpbc, gen or genpbc.\n");
+        printf(" -hacks <file>\t speed hack database. (default: hacks.txt)\n");
+        printf(" -nohacks     \t don't use speed hacks.\n");
+        printf(" -overclock <n>\t give the Z80 n hidden lines each frame. (0-262)\n");
+        printf(" -core <name> \t Z80 core: default, exact, fast or lean.\n");
+        exit(1);
+    }
+
+    set_option_defaults();
+    worker_count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    for(i = 2; i < argc; i += n)
+    {
+        if(strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+        {
+            worker_count = atoi(argv[i + 1]);
+            n = 2;
+        }
+        else
+        if(strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+        {
+            out_dir = argv[i + 1];
+            n = 2;
+        }
+        else
+        if((n = parse_option(argc, argv, i)) == 0)
+        {
+            printf("Unknown option `%s'.\n", argv[i]);
+            exit(1);
+        }
+    }
+
+    if(!load_jobs(argv[1]) || job_count == 0)
+    {
+        printf("Error loading job list `%s'.\n", argv[1]);
+        exit(1);
+    }
+
+    if(worker_count < 1)
+        worker_count = 1;
+    if(worker_count > job_count)
+        worker_count = job_count;
+
+    /* Results and deques are shared with the workers */
+    result = mmap(NULL, job_count * sizeof(t_result) + worker_count * sizeof(t_deque),
+        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if(result == MAP_FAILED)
+    {
+        printf("Error allocating shared memory.\n");
+        exit(1);
+    }
+    deque = (t_deque *)&result[job_count];
+
+    for(i = 0; i < job_count; i++)
+        result[i].worker = -1;
+
+    for(i = 0; i < worker_count; i++)
+    {
+        deque[i].top = job_count * i / worker_count;
+        deque[i].bottom = job_count * (i + 1) / worker_count;
+    }
+
+    pid = calloc(worker_count, sizeof(pid_t));
+    if(!pid)
+        exit(1);
+
+    /* Keep our buffered output out of the children */
+    fflush(stdout);
+
+    start = headless_time();
+
+    for(i = 0, running = 0; i < worker_count; i++)
+    {
+        pid[i] = spawn_worker(i);
+        if(pid[i] > 0)
+            running++;
+    }
+
+    while(running)
+    {
+        int status, w;
+        pid_t p = wait(&status);
+
+        if(p < 0)
+            break;
+
+        for(w = 0; w < worker_count && pid[w] != p; w++)
+            ;
+        if(w == worker_count)
+            continue;
+
+        running--;
+        pid[w] = 0;
+
+        if(WIFEXITED(status) && WEXITSTATUS(status) == 0)
+            continue;
+
+        /* The worker died mid-job: fail that job and start a replacement */
+        for(i = 0; i < job_count; i++)
+        {
+            if(result[i].worker == w && result[i].status == JOB_RUNNING)
+                result[i].status = JOB_FAILED;
+        }
+
+        /* A crash may have left the deque locked */
+        deque[w].lock = 0;
+
+        pid[w] = spawn_worker(w);
+        if(pid[w] > 0)
+            running++;
+    }
+
+    report(headless_time() - start);
+
+    munmap(result, job_count * sizeof(t_result) + worker_count * sizeof(t_deque));
+    free(pid);
+    free(job);
+    return 0;
+}
@@ -0,0 +1,359 @@
+/*
+    discover.c --
+    Speed hack discovery.
+
+    A game is run headless while every taken backward branch samples the
+    PC, weighted by the cycles run since the previous sample, which shows
+    the loops the game spends its time in. Each loop that takes a large
+    enough share is then tried as an idle hack, ending the time slice when
+    its branch is taken. A hack is kept only if every frame's video and
+    audio hash is unchanged from the run without hacks, and the kept ones
+    are written to the speed hack database.
+*/
+
+#include "osd.h"
+#include <limits.h>
+
+#define TABLE_SIZE      0x1000
+
+/* Cycles spent in one loop */
+typedef struct
+{
+    uint32 key;
+    double cycles;
+} t_loop;
+
+/* Hashes and time of one run */
+typedef struct
+{
+    uint32 *video;
+    uint32 *audio;
+    double ns_frame;
+} t_run;
+
+static int frames = 1200;
+static int max_tries = 8;
+static double min_share = 2.0;
+static char *db_file = HACKS_FILE;
+static char *script_name = "-";
+static int dry_run = 0;
+
+static t_loop loop[TABLE_SIZE];
+static double total_cycles;
+static int last_cycles;
+
+static hack_t hack[HACK_MAX];
+static int hack_count;
+
+
+/* Key of a loop: bank in the upper half, branch PC in the lower */
+static uint32 loop_key(int pc)
+{
+    return (hacks_bank(pc) << 16) | pc;
+}
+
+
+/* Charge the cycles since the previous sample to the branch at 'pc' */
+static int sample(uint16 pc)
+{
+    int now = z80_get_elapsed_cycles();
+    uint32 key = loop_key(pc) | 0x80000000;
+    int i = (key * 0x9E3779B1) >> 20;
+    int n;
+
+    for(n = 0; n < TABLE_SIZE; n++, i = (i + 1) & (TABLE_SIZE - 1))
+    {
+        if(loop[i].key == key || loop[i].key == 0)
+        {
+            loop[i].key = key;
+            loop[i].cycles += (uint32)(now - last_cycles);
+            break;
+        }
+    }
+
+    total_cycles += (uint32)(now - last_cycles);
+    last_cycles = now;
+
+    /* Only looking, the branch runs as usual */
+    return 0;
+}
+
+
+static int loop_cmp(const void *a, const void *b)
+{
+    const t_loop *la = a, *lb = b;
+    return (lb->cycles > la->cycles) - (lb->cycles < la->cycles);
+}
+
+
+/*
+    Run the game with the listed hacks, or with the PC sampler if 'profile'
+    is set, and hash every frame.
+*/
+static int run_game(char *rom, t_input_script *script, hack_t *list, int count,
+    int profile, t_run *run)
+{
+    double elapsed = 0.0;
+    int i;
+
+    if(!headless_init(rom))
+        return 0;
+
+    /* Only the idle hacks being tried, not those already in the database.
+       The game's overclock stays on, as it will be when the hacks are used */
+    hacks_remove(HACK_IDLE);
+    for(i = 0; i < count; i++)
+        hacks_add(list[i].type, list[i].pc, list[i].bank);
+
+    if(profile)
+    {
+        memset(loop, 0, sizeof(loop));
+        total_cycles = 0.0;
+        last_cycles = z80_get_elapsed_cycles();
+        cpu_idlepc16 = sample;
+    }
+
+    script->next = 0;
+
+    for(i = 0; i < frames; i++)
+    {
+        double start;
+
+        script_apply(script, i);
+
+        start = headless_time();
+        system_frame(0);
+        elapsed += headless_time() - start;
+
+        run->video[i] = video_crc(0);
+        run->audio[i] = audio_crc(0);
+    }
+
+    run->ns_frame = elapsed * 1e9 / frames;
+
+    headless_shutdown();
+    return 1;
+}
+
+
+/* Returns the first frame that differs, or -1 if none do */
+static int compare(t_run *a, t_run *b)
+{
+    int i;
+
+    for(i = 0; i < frames; i++)
+    {
+        if(a->video[i] != b->video[i] || a->audio[i] != b->audio[i])
+            return i;
+    }
+
+    return -1;
+}
+
+
+static int run_alloc(t_run *run)
+{
+    run->video = calloc(frames, sizeof(uint32));
+    run->audio = calloc(frames, sizeof(uint32));
+    return (run->video && run->audio);
+}
+
+
+static void run_free(t_run *run)
+{
+    free(run->video);
+    free(run->audio);
+}
+
+
+static int discover(char *rom)
+{
+    t_input_script script;
+    t_run ref, cur;
+    uint32 crc;
+    char *base;
+    int i, tries, ok = 0;
+
+    if(!script_load(&script, script_name))
+    {
+        printf("Can't load input script `%s'.\n", script_name);
+        return 0;
+    }
+
+    memset(&ref, 0, sizeof(t_run));
+    memset(&cur, 0, sizeof(t_run));
+    if(!run_alloc(&ref) || !run_alloc(&cur))
+        goto done;
+
+    if(!run_game(rom, &script, NULL, 0, 1, &ref))
+    {
+        printf("Error loading `%s'.\n", rom);
+        goto done;
+    }
+
+    crc = cart.crc;
+    base = strrchr(rom, '/');
+    base = base ? base + 1 : rom;
+
+    printf("%s: crc %08X, %d frames, %.0f ns/frame\n\n", base, crc, frames, ref.ns_frame);
+    printf("%-4s %-4s %7s  %s\n", "bank", "pc", "cycles", "result");
+
+    qsort(loop, TABLE_SIZE, sizeof(t_loop), loop_cmp);
+
+    /*
+        Try the busiest loops in turn, each on top of those already kept,
+        so the final set is known to work as a whole.
+    */
+    hack_count = 0;
+
+    for(i = 0, tries = 0; i < TABLE_SIZE && tries < max_tries; i++)
+    {
+        t_loop *l = &loop[i];
+        double share = total_cycles > 0.0 ? 100.0 * l->cycles / total_cycles : 0.0;
+        int bank = (l->key >> 16) & 0xFF;
+        int pc = l->key & 0xFFFF;
+        int first;
+
+        if(!l->key || share < min_share || hack_count == HACK_MAX)
+            break;
+
+        printf("%02X   %04X %6.1f%%  ", bank, pc, share);
+
+        /* Code outside the ROM may change under the hack */
+        if(bank == HACK_BANK_RAM)
+        {
+            printf("skipped, not in ROM\n");
+            continue;
+        }
+
+        tries++;
+        hack[hack_count].type = HACK_IDLE;
+        hack[hack_count].pc = pc;
+        hack[hack_count].bank = bank;
+
+        if(!run_game(rom, &script, hack, hack_count + 1, 0, &cur))
+            break;
+
+        first = compare(&ref, &cur);
+        if(first < 0)
+        {
+            printf("kept, %.0f ns/frame (%+.1f%%)\n", cur.ns_frame,
+                100.0 * (cur.ns_frame - ref.ns_frame) / ref.ns_frame);
+            hack_count++;
+        }
+        else
+            printf("output differs at frame %d\n", first);
+    }
+
+    printf("\n%d hack%s verified for %s\n", hack_count, hack_count == 1 ? "" : "s", base);
+
+    ok = 1;
+
+    if(hack_count && !dry_run)
+    {
+        /* hacks_save() writes the active set */
+        hacks_remove(HACK_IDLE);
+        for(i = 0; i < hack_count; i++)
+            hacks_add(hack[i].type, hack[i].pc, hack[i].bank);
+
+        if(hacks_save(db_file, crc, base))
+            printf("written to `%s'.\n", db_file);
+        else
+        {
+            printf("can't write `%s'.\n", db_file);
+            ok = 0;
+        }
+    }
+
+done:
+    run_free(&ref);
+    run_free(&cur);
+    script_free(&script);
+    return ok;
+}
+
+
+int main(int argc, char **argv)
+{
+    int i, n;
+
+    /* Show usage if no arguments are specified */
+    if(argc < 2)
+    {
+        printf("\n%s speed hack discovery\n", APP_NAME);
+        printf("Version %s, build date: %s, %s\n", APP_VERSION, __DATE__, __TIME__);
+        printf("Usage: smsdiscover <filename.ext> [-options]\n");
+        printf("Options:\n");
+        printf(" -frames <n>  \t frames to run and compare. (default: 1200)\n");
+        printf(" -script <file>\t input script to play.\n");
+        printf(" -tries <n>   \t loops to try at most. (default: 8)\n");
+        printf(" -min <pct>   \t smallest share of cycles for a loop to be tried. (default: 2)\n");
+        printf(" -db <file>   \t database to update. (default: hacks.txt)\n");
+        printf(" -dry         \t don't update the database.\n");
+        printf(" -sndrate <n> \t specify sound rate. (8000-48000)\n");
+        printf(" -depth <n>   \t specify color depth. (8, 16)\n");
+        printf(" -fm          \t enable YM2413 sound.\n");
+        printf(" -jp          \t use Japanese console type.\n");
+        printf(" -codies      \t force Codemasters mapper.\n");
+        printf(" -console <name>\t sms, smsj, sms2, gg, ggms, md, mdpbc, gen or genpbc.\n");
+        printf(" -overclock <n>\t give the Z80 n hidden lines each frame. (0-262)\n");
+        printf(" -core <name> \t Z80 core: default, exact, fast or lean.\n");
+        exit(1);
+    }
+
+    set_option_defaults();
+
+    for(i = 2; i < argc; i += n)
+    {
+        if(strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+        {
+            frames = atoi(argv[i + 1]);
+            n = 2;
+        }
+        else
+        if(strcmp(argv[i], "-script") == 0 && i + 1 < argc)
+        {
+            script_name = argv[i + 1];
+            n = 2;
+        }
+        else
+        if(strcmp(argv[i], "-tries") == 0 && i + 1 < argc)
+        {
+            max_tries = atoi(argv[i + 1]);
+            n = 2;
+        }
+        else
+        if(strcmp(argv[i], "-min") == 0 && i + 1 < argc)
+        {
+            min_share = atof(argv[i + 1]);
+            n = 2;
+        }
+        else
+        if(strcmp(argv[i], "-db") == 0 && i + 1 < argc)
+        {
+            db_file = argv[i + 1];
+            n = 2;
+        }
+        else
+        if(strcmp(argv[i], "-dry") == 0)
+        {
+            dry_run = 1;
+            n = 1;
+        }
+        else
+        if((n = parse_option(argc, argv, i)) == 0)
+        {
+            printf("Unknown option `%s'.\n", argv[i]);
+            exit(1);
+        }
+    }
+
+    if(frames < 1)
+        frames = 1;
+
+    /* Hacks are checked against both outputs */
+    option.render = 1;
+    option.sound = 1;
+
+    return discover(argv[1]) ? 0 : 1;
+}
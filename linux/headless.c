@@ -0,0 +1,444 @@
+/*
+    headless.c --
+    Display-less host shared by the Linux benchmark and test tools.
+*/
+
+#include "osd.h"
+
+
+/* Options structure */
+t_option option;
+
+/* Console driven by the calling thread */
+THREAD_LOCAL instance_t *headless_inst = NULL;
+
+/* Names accepted by -console */
+static const struct
+{
+    char *name;
+    int console;
+} console_list[] = {
+    { "sms",    CONSOLE_SMS     },
+    { "smsj",   CONSOLE_SMSJ    },
+    { "sms2",   CONSOLE_SMS2    },
+    { "gg",     CONSOLE_GG      },
+    { "ggms",   CONSOLE_GGMS    },
+    { "md",     CONSOLE_MD      },
+    { "mdpbc",  CONSOLE_MDPBC   },
+    { "gen",    CONSOLE_GEN     },
+    { "genpbc", CONSOLE_GENPBC  },
+};
+
+
+void set_option_defaults(void)
+{
+    option.video_depth  = 8;
+    option.render       = 1;
+    option.sound        = 1;
+    option.sndrate      = 44100;
+    option.country      = TERRITORY_EXPORT;
+    option.fm_enable    = 0;
+    option.codies       = 0;
+    option.console      = 0;
+    option.overclock    = 0;
+    option.core         = "default";
+
+    /* Speed hacks found by smsdiscover, if any */
+    hacks_load(HACKS_FILE);
+}
+
+
+/* Parse one common option, returns the number of arguments used */
+int parse_option(int argc, char **argv, int i)
+{
+    if(strcmp(argv[i], "-norender") == 0)
+    {
+        option.render = 0;
+        return 1;
+    }
+
+    if(strcmp(argv[i], "-nosound") == 0)
+    {
+        option.sound = 0;
+        return 1;
+    }
+
+    if(strcmp(argv[i], "-fm") == 0)
+    {
+        option.fm_enable = 1;
+        return 1;
+    }
+
+    if(strcmp(argv[i], "-jp") == 0)
+    {
+        option.country = TERRITORY_DOMESTIC;
+        return 1;
+    }
+
+    if(strcmp(argv[i], "-codies") == 0)
+    {
+        option.codies = 1;
+        return 1;
+    }
+
+    if(strcmp(argv[i], "-console") == 0 && i + 1 < argc)
+    {
+        int j;
+
+        for(j = 0; j < sizeof(console_list) / sizeof(console_list[0]); j++)
+        {
+            if(strcmp(argv[i + 1], console_list[j].name) == 0)
+            {
+                option.console = console_list[j].console;
+                return 2;
+            }
+        }
+
+        printf("Unknown console `%s'.\n", argv[i + 1]);
+        exit(1);
+    }
+
+    if(strcmp(argv[i], "-nohacks") == 0)
+    {
+        hacks_free();
+        return 1;
+    }
+
+    if(strcmp(argv[i], "-overclock") == 0 && i + 1 < argc)
+    {
+        option.overclock = atoi(argv[i + 1]);
+        return 2;
+    }
+
+    if(strcmp(argv[i], "-hacks") == 0 && i + 1 < argc)
+    {
+        hacks_load(argv[i + 1]);
+        return 2;
+    }
+
+#ifdef Z80_CORES
+    if(strcmp(argv[i], "-core") == 0 && i + 1 < argc)
+    {
+        if(!z80_select_core(argv[i + 1]))
+        {
+            printf("Unknown Z80 core `%s'.\n", argv[i + 1]);
+            exit(1);
+        }
+        option.core = argv[i + 1];
+        return 2;
+    }
+#endif
+
+    if(strcmp(argv[i], "-depth") == 0 && i + 1 < argc)
+    {
+        option.video_depth = (atoi(argv[i + 1]) == 16) ? 16 : 8;
+        return 2;
+    }
+
+    if(strcmp(argv[i], "-sndrate") == 0 && i + 1 < argc)
+    {
+        option.sndrate = atoi(argv[i + 1]);
+        return 2;
+    }
+
+    return 0;
+}
+
+
+/* Fill in an instance configuration from the options */
+void headless_config(instance_config_t *config)
+{
+    memset(config, 0, sizeof(instance_config_t));
+    config->depth       = option.video_depth;
+    config->sample_rate = option.sound ? option.sndrate : 0;
+    config->use_fm      = option.fm_enable;
+    config->territory   = option.country;
+    config->codies      = option.codies;
+    config->console     = option.console;
+    config->overclock   = option.overclock;
+    config->core        = option.core;
+}
+
+
+/* Load a game and bring the virtual console up on this thread */
+int headless_init(char *filename)
+{
+    instance_config_t config;
+
+    headless_config(&config);
+    headless_inst = instance_create(filename, &config);
+    return (headless_inst != NULL);
+}
+
+
+void headless_shutdown(void)
+{
+    instance_destroy(headless_inst);
+    headless_inst = NULL;
+}
+
+
+/* Monotonic time in seconds */
+double headless_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+
+/* Peak resident set size in kilobytes */
+long headless_peak_rss(void)
+{
+    struct rusage ru;
+    if(getrusage(RUSAGE_SELF, &ru) != 0)
+        return 0;
+    return ru.ru_maxrss;
+}
+
+
+/*--------------------------------------------------------------------------*/
+/* Input scripts                                                            */
+/*--------------------------------------------------------------------------*/
+
+/*
+    Each line holds '<frame> <pad0> [<pad1> [<system>]]' with the masks in
+    hex (see INPUT_* in system.h). The state holds until the next line;
+    blank lines and lines starting with '#' are ignored.
+*/
+int script_load(t_input_script *script, char *filename)
+{
+    char line[0x100];
+    int size = 0;
+    FILE *fd;
+
+    memset(script, 0, sizeof(t_input_script));
+
+    if(!filename || strcmp(filename, "-") == 0)
+        return 1;
+
+    fd = fopen(filename, "r");
+    if(!fd)
+        return 0;
+
+    while(fgets(line, sizeof(line), fd))
+    {
+        t_input_event e;
+        unsigned int pad0 = 0, pad1 = 0, sys = 0;
+
+        if(line[0] == '#')
+            continue;
+
+        if(sscanf(line, "%d %x %x %x", &e.frame, &pad0, &pad1, &sys) < 2)
+            continue;
+
+        e.pad[0] = pad0;
+        e.pad[1] = pad1;
+        e.system = sys;
+
+        if(script->count == size)
+        {
+            t_input_event *p;
+            size = size ? size * 2 : 64;
+            p = realloc(script->event, size * sizeof(t_input_event));
+            if(!p)
+            {
+                fclose(fd);
+                script_free(script);
+                return 0;
+            }
+            script->event = p;
+        }
+
+        script->event[script->count++] = e;
+    }
+
+    fclose(fd);
+    return 1;
+}
+
+
+/* Update 'input' for the given frame, frames must be visited in order */
+void script_apply(t_input_script *script, int frame)
+{
+    while(script->next < script->count && script->event[script->next].frame <= frame)
+    {
+        t_input_event *e = &script->event[script->next++];
+        input.pad[0] = e->pad[0];
+        input.pad[1] = e->pad[1];
+        input.system = e->system;
+    }
+}
+
+
+void script_free(t_input_script *script)
+{
+    free(script->event);
+    memset(script, 0, sizeof(t_input_script));
+}
+
+
+/*--------------------------------------------------------------------------*/
+/* Output files                                                             */
+/*--------------------------------------------------------------------------*/
+
+/* Fold the visible part of the display into a running CRC */
+uint32 video_crc(uint32 crc)
+{
+    int y;
+    int bpp = bitmap.depth >> 3;
+
+    for(y = 0; y < bitmap.viewport.h; y++)
+    {
+        uint8 *src = &bitmap.data[(y + bitmap.viewport.y) * bitmap.pitch];
+        crc = crc32(crc, src + bitmap.viewport.x * bpp, bitmap.viewport.w * bpp);
+    }
+
+    return crc;
+}
+
+
+/* Fold the samples generated by the last frame into a running CRC */
+uint32 audio_crc(uint32 crc)
+{
+    if(!snd.enabled)
+        return crc;
+
+    crc = crc32(crc, (uint8 *)snd.output[0], snd.sample_count * 2);
+    crc = crc32(crc, (uint8 *)snd.output[1], snd.sample_count * 2);
+    return crc;
+}
+
+
+/* Save the visible part of the display as a binary PPM */
+int snap_save(char *filename)
+{
+    int x, y;
+    FILE *fd = fopen(filename, "wb");
+
+    if(!fd)
+        return 0;
+
+    fprintf(fd, "P6\n%d %d\n255\n", bitmap.viewport.w, bitmap.viewport.h);
+
+    for(y = 0; y < bitmap.viewport.h; y++)
+    {
+        uint8 *src = &bitmap.data[(y + bitmap.viewport.y) * bitmap.pitch];
+
+        for(x = bitmap.viewport.x; x < bitmap.viewport.x + bitmap.viewport.w; x++)
+        {
+            uint8 rgb[3];
+
+            if(bitmap.depth == 8)
+            {
+                memcpy(rgb, bitmap.pal.color[src[x] & PIXEL_MASK], 3);
+            }
+            else
+            {
+                uint16 p = ((uint16 *)src)[x];
+                rgb[0] = (p >> 8) & 0xF8;
+                rgb[1] = (p >> 3) & 0xFC;
+                rgb[2] = (p << 3) & 0xF8;
+            }
+
+            fwrite(rgb, 3, 1, fd);
+        }
+    }
+
+    fclose(fd);
+    return 1;
+}
+
+
+static void put_le(FILE *fd, uint32 value, int size)
+{
+    while(size--)
+    {
+        fputc(value & 0xFF, fd);
+        value >>= 8;
+    }
+}
+
+
+static void wav_header(t_wav *wav)
+{
+    uint32 bytes = wav->samples * 4;
+
+    fwrite("RIFF", 4, 1, wav->fd);
+    put_le(wav->fd, 36 + bytes, 4);
+    fwrite("WAVEfmt ", 8, 1, wav->fd);
+    put_le(wav->fd, 16, 4);
+    put_le(wav->fd, 1, 2);
+    put_le(wav->fd, 2, 2);
+    put_le(wav->fd, snd.sample_rate, 4);
+    put_le(wav->fd, snd.sample_rate * 4, 4);
+    put_le(wav->fd, 4, 2);
+    put_le(wav->fd, 16, 2);
+    fwrite("data", 4, 1, wav->fd);
+    put_le(wav->fd, bytes, 4);
+}
+
+
+/* Start capturing 16-bit stereo audio, needs sound to be enabled */
+int wav_open(t_wav *wav, char *filename)
+{
+    memset(wav, 0, sizeof(t_wav));
+
+    if(!snd.enabled)
+        return 0;
+
+    wav->fd = fopen(filename, "wb");
+    if(!wav->fd)
+        return 0;
+
+    wav_header(wav);
+    return 1;
+}
+
+
+/* Append the samples generated by the last frame */
+void wav_update(t_wav *wav)
+{
+    int i;
+
+    if(!wav->fd)
+        return;
+
+    for(i = 0; i < snd.sample_count; i++)
+    {
+        put_le(wav->fd, (uint16)snd.output[0][i], 2);
+        put_le(wav->fd, (uint16)snd.output[1][i], 2);
+    }
+
+    wav->samples += snd.sample_count;
+}
+
+
+void wav_close(t_wav *wav)
+{
+    if(!wav->fd)
+        return;
+
+    /* Rewrite the header now the length is known */
+    fseek(wav->fd, 0, SEEK_SET);
+    wav_header(wav);
+    fclose(wav->fd);
+    wav->fd = NULL;
+}
+
+
+/*--------------------------------------------------------------------------*/
+
+/* SRAM is never persisted, so every run starts from the same state */
+void system_manage_sram(uint8 *sram, int slot, int mode)
+{
+    switch(mode)
+    {
+        case SRAM_SAVE:
+            break;
+
+        case SRAM_LOAD:
+            memset(sram, 0x00, 0x8000);
+            break;
+    }
+}
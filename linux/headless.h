@@ -0,0 +1,66 @@
+
+#ifndef _HEADLESS_H_
+#define _HEADLESS_H_
+
+typedef struct
+{
+    int video_depth;
+    int render;
+    int sound;
+    int sndrate;
+    int country;
+    int fm_enable;
+    int codies;
+    int console;
+    int overclock;
+    char *core;
+}t_option;
+
+/* Scripted controller input: from 'frame' onward the pads read as given */
+typedef struct
+{
+    int frame;
+    uint32 pad[2];
+    uint32 system;
+}t_input_event;
+
+typedef struct
+{
+    int count;
+    int next;
+    t_input_event *event;
+}t_input_script;
+
+/* Streamed audio capture */
+typedef struct
+{
+    FILE *fd;
+    uint32 samples;
+}t_wav;
+
+/* Speed hack database read by default */
+#define HACKS_FILE      "hacks.txt"
+
+/* Global data */
+extern t_option option;
+extern THREAD_LOCAL instance_t *headless_inst;
+
+/* Function prototypes */
+void set_option_defaults(void);
+int parse_option(int argc, char **argv, int i);
+void headless_config(instance_config_t *config);
+int headless_init(char *filename);
+void headless_shutdown(void);
+double headless_time(void);
+long headless_peak_rss(void);
+int script_load(t_input_script *script, char *filename);
+void script_apply(t_input_script *script, int frame);
+void script_free(t_input_script *script);
+uint32 video_crc(uint32 crc);
+uint32 audio_crc(uint32 crc);
+int snap_save(char *filename);
+int wav_open(t_wav *wav, char *filename);
+void wav_update(t_wav *wav);
+void wav_close(t_wav *wav);
+
+#endif /* _HEADLESS_H_ */
@@ -0,0 +1,436 @@
+/*
+    kernels.c --
+    Microbenchmarks for the hot rendering, sound and CPU kernels.
+
+    Each kernel is run in isolation on fixed synthetic input, so a change
+    to one of them can be measured without the rest of the frame getting
+    in the way. Cycles are counted with stats_clock(), which is the time
+    stamp counter on x86.
+*/
+
+#include "osd.h"
+
+/* Samples generated per sound pass */
+#define SAMPLES         4096
+
+/* Lines drawn per render pass */
+#define LINES           (8 * 192)
+
+/*
+    The CPU kernel runs this loop, which copies 256 bytes with some ALU
+    work and then calls a subroutine. It is 1797 instructions and 13107
+    cycles long, which gives the instruction count for a run.
+*/
+static uint8 z80_loop[] = {
+    0xF3,                   /* 0000: DI             */
+    0x31, 0xF0, 0xDF,       /* 0001: LD SP,$DFF0    */
+    0x21, 0x00, 0x00,       /* 0004: LD HL,$0000    */
+    0x11, 0x00, 0xC0,       /* 0007: LD DE,$C000    */
+    0x06, 0x00,             /* 000A: LD B,$00       */
+    0x7E,                   /* 000C: LD A,(HL)      */
+    0x80,                   /* 000D: ADD A,B        */
+    0x12,                   /* 000E: LD (DE),A      */
+    0x23,                   /* 000F: INC HL         */
+    0x13,                   /* 0010: INC DE         */
+    0xCB, 0x3F,             /* 0011: SRL A          */
+    0x10, 0xF7,             /* 0013: DJNZ $000C     */
+    0x11, 0x00, 0xC0,       /* 0015: LD DE,$C000    */
+    0xCD, 0x20, 0x00,       /* 0018: CALL $0020     */
+    0x18, 0xED,             /* 001B: JR $000A       */
+    0x00, 0x00, 0x00,       /* 001D: NOP            */
+    0xC9,                   /* 0020: RET            */
+};
+
+#define LOOP_INSTRUCTIONS   1797
+#define LOOP_CYCLES         13107
+
+typedef struct
+{
+    char *name;
+    char *unit;
+    void (*prepare)(void);      /* Set up the input, not timed */
+    double (*run)(void);        /* One timed pass, returns units processed */
+} t_kernel;
+
+static int passes = 20;
+static int csv = 0;
+static char *only = NULL;
+
+static uint32 seed = 1;
+static int16 *sample_buffer[2];
+static OPLL *opll;
+
+
+static uint8 random8(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) & 0xFF;
+}
+
+
+static void vdp_set_reg(int r, int d)
+{
+    vdp_write(1, d);
+    vdp_write(1, 0x80 | r);
+}
+
+
+/* Fill VRAM and CRAM through the data port so dirty tracking sees it */
+static void vdp_fill(void)
+{
+    int i;
+
+    vdp_write(1, 0x00);
+    vdp_write(1, 0x40);
+    for(i = 0; i < 0x4000; i++)
+        vdp_write(0, random8());
+
+    /* Sprite Y positions spread out so most lines hold eight sprites */
+    vdp_write(1, 0x00);
+    vdp_write(1, 0x40 | 0x3F);
+    for(i = 0; i < 64; i++)
+        vdp_write(0, (i * 3) % 0xC0);
+
+    vdp_write(1, 0x00);
+    vdp_write(1, 0xC0);
+    for(i = 0; i < 0x20; i++)
+        vdp_write(0, random8());
+}
+
+
+static void prepare_sms(void)
+{
+    vdp_set_reg(0, 0x04);
+    vdp_set_reg(1, 0xE2);
+    vdp_set_reg(2, 0xFF);
+    vdp_set_reg(5, 0xFF);
+    vdp_set_reg(6, 0xFF);
+    vdp_set_reg(7, 0x00);
+    vdp_set_reg(8, 0x13);
+    vdp_set_reg(9, 0x00);
+    update_bg_pattern_cache();
+    linebuf = &internal_buffer[0];
+}
+
+
+static double run_bg_sms(void)
+{
+    int i;
+    for(i = 0; i < LINES; i++)
+        render_bg_sms(i % 192);
+    return LINES * 256.0;
+}
+
+
+static double run_obj_sms(void)
+{
+    int i;
+    for(i = 0; i < LINES; i++)
+        render_obj_sms(i % 192);
+    return LINES * 256.0;
+}
+
+
+/* Mark every pattern as changed */
+static void prepare_cache(void)
+{
+    int i;
+
+    for(i = 0; i < 0x200; i++)
+    {
+        bg_name_dirty[i] = 0xFF;
+        bg_name_list[i] = i;
+    }
+    bg_list_index = 0x200;
+}
+
+
+static double run_cache(void)
+{
+    update_bg_pattern_cache();
+    return 0x200 * 64.0;
+}
+
+
+static void prepare_remap(void)
+{
+    int i;
+    for(i = 0; i < 0x100; i++)
+        internal_buffer[i] = random8();
+}
+
+
+static double run_remap(void)
+{
+    int i;
+    for(i = 0; i < LINES; i++)
+        remap_8_to_16(i % 192);
+    return LINES * (double)bitmap.viewport.w;
+}
+
+
+/* Select a TMS9918 mode from its M1-M3 bits */
+static void prepare_tms(int mode)
+{
+    vdp_set_reg(0, (mode & 2) ? 0x02 : 0x00);
+    vdp_set_reg(1, 0xC0 | ((mode & 1) ? 0x10 : 0) | ((mode & 4) ? 0x08 : 0));
+    vdp_set_reg(2, 0x0E);
+    vdp_set_reg(3, 0xFF);
+    vdp_set_reg(4, 0x03);
+    vdp_set_reg(5, 0x76);
+    vdp_set_reg(6, 0x03);
+    vdp_set_reg(7, 0x17);
+    linebuf = &internal_buffer[0];
+}
+
+static void prepare_m0(void)  { prepare_tms(0); }
+static void prepare_m1(void)  { prepare_tms(1); }
+static void prepare_m2(void)  { prepare_tms(2); }
+static void prepare_m1x(void) { prepare_tms(3); }
+static void prepare_m3(void)  { prepare_tms(4); }
+static void prepare_m3x(void) { prepare_tms(6); }
+
+
+#define RUN_TMS(name) \
+static double run_##name(void) \
+{ \
+    int i; \
+    for(i = 0; i < LINES; i++) \
+        render_bg_##name(i % 192); \
+    return LINES * 256.0; \
+}
+
+RUN_TMS(m0)
+RUN_TMS(m1)
+RUN_TMS(m1x)
+RUN_TMS(m2)
+RUN_TMS(m3)
+RUN_TMS(m3x)
+
+
+static double run_psg(void)
+{
+    SN76489_Update(0, sample_buffer, SAMPLES);
+    return SAMPLES;
+}
+
+
+static double run_opll(void)
+{
+    OPLL_update(opll, sample_buffer, SAMPLES);
+    return SAMPLES;
+}
+
+
+static double run_ym2413(void)
+{
+    YM2413UpdateOne(0, sample_buffer, SAMPLES);
+    return SAMPLES;
+}
+
+
+static void prepare_z80(void)
+{
+    z80_reset(NULL);
+}
+
+
+static double run_z80(void)
+{
+    int cycles = z80_execute(LOOP_CYCLES * 64);
+    return (double)cycles * LOOP_INSTRUCTIONS / LOOP_CYCLES;
+}
+
+
+static t_kernel kernel[] = {
+    { "render_bg_sms",              "pixel",  prepare_sms,    run_bg_sms },
+    { "render_obj_sms",             "pixel",  prepare_sms,    run_obj_sms },
+    { "update_bg_pattern_cache",    "pixel",  prepare_cache,  run_cache },
+    { "remap_8_to_16",              "pixel",  prepare_remap,  run_remap },
+    { "render_bg_m0",               "pixel",  prepare_m0,     run_m0 },
+    { "render_bg_m1",               "pixel",  prepare_m1,     run_m1 },
+    { "render_bg_m1x",              "pixel",  prepare_m1x,    run_m1x },
+    { "render_bg_m2",               "pixel",  prepare_m2,     run_m2 },
+    { "render_bg_m3",               "pixel",  prepare_m3,     run_m3 },
+    { "render_bg_m3x",              "pixel",  prepare_m3x,    run_m3x },
+    { "SN76489_Update",             "sample", NULL,           run_psg },
+    { "OPLL_update",                "sample", NULL,           run_opll },
+    { "YM2413UpdateOne",            "sample", NULL,           run_ym2413 },
+    { "z80_execute",                "instr",  prepare_z80,    run_z80 },
+    { NULL, NULL, NULL, NULL }
+};
+
+
+/* Write the CPU loop out as a game so the console can be brought up */
+static int make_rom(char *filename)
+{
+    static uint8 rom[0x8000];
+    int fd = mkstemps(filename, 4);
+
+    if(fd < 0)
+        return 0;
+
+    memset(rom, 0, sizeof(rom));
+    memcpy(rom, z80_loop, sizeof(z80_loop));
+
+    if(write(fd, rom, sizeof(rom)) != sizeof(rom))
+    {
+        close(fd);
+        return 0;
+    }
+
+    close(fd);
+    return 1;
+}
+
+
+/* Program tones on every channel of both sound chips */
+static void sound_setup(void)
+{
+    static uint8 psg_data[] = {
+        0x8E, 0x0F, 0x90, 0xA5, 0x0A, 0xB2, 0xC7, 0x04, 0xD4, 0xE4, 0xF3
+    };
+    int i;
+
+    for(i = 0; i < sizeof(psg_data); i++)
+        SN76489_Write(0, psg_data[i]);
+
+    opll = OPLL_new();
+    OPLL_reset(opll);
+    OPLL_reset_patch(opll, 0);
+
+    YM2413Init(1, snd.fm_clock, snd.sample_rate);
+    YM2413ResetChip(0);
+
+    for(i = 0; i < 9; i++)
+    {
+        int fnum = 0x100 + i * 0x20;
+        int inst = ((i + 1) << 4) | 0x02;
+
+        OPLL_writeReg(opll, 0x10 + i, fnum & 0xFF);
+        OPLL_writeReg(opll, 0x30 + i, inst);
+        OPLL_writeReg(opll, 0x20 + i, 0x10 | 0x04 | (fnum >> 8));
+
+        YM2413Write(0, 0, 0x10 + i); YM2413Write(0, 1, fnum & 0xFF);
+        YM2413Write(0, 0, 0x30 + i); YM2413Write(0, 1, inst);
+        YM2413Write(0, 0, 0x20 + i); YM2413Write(0, 1, 0x10 | 0x04 | (fnum >> 8));
+    }
+}
+
+
+static void bench(t_kernel *k)
+{
+    double best = 0.0, units = 0.0;
+    int i;
+
+    for(i = 0; i <= passes; i++)
+    {
+        stats_tick_t start;
+        double ticks;
+
+        if(k->prepare)
+            k->prepare();
+
+        start = stats_clock();
+        units = k->run();
+        ticks = (double)(stats_clock() - start);
+
+        /* The first pass only warms up caches and branch predictors */
+        if(i && (best == 0.0 || ticks < best))
+            best = ticks;
+    }
+
+    if(csv)
+        printf("%s,%s,%.0f,%.3f,%.3f\n", k->name, k->unit, units,
+            best / units, best * stats_tick_ns() / units);
+    else
+        printf("%-26s %10.0f %-6s %12.3f %12.3f\n", k->name, units, k->unit,
+            best / units, best * stats_tick_ns() / units);
+}
+
+
+int main(int argc, char **argv)
+{
+    char rom_name[] = "/tmp/smskernelsXXXXXX.sms";
+    int i, n;
+
+    set_option_defaults();
+
+    for(i = 1; i < argc; i += n)
+    {
+        n = 1;
+
+        if(strcmp(argv[i], "-csv") == 0)
+            csv = 1;
+        else
+        if(strcmp(argv[i], "-passes") == 0 && i + 1 < argc)
+        {
+            passes = atoi(argv[i + 1]);
+            n = 2;
+        }
+        else
+        if(strcmp(argv[i], "-kernel") == 0 && i + 1 < argc)
+        {
+            only = argv[i + 1];
+            n = 2;
+        }
+        else
+        {
+            printf("\n%s kernel microbenchmarks\n", APP_NAME);
+            printf("Version %s, build date: %s, %s\n", APP_VERSION, __DATE__, __TIME__);
+            printf("Usage: smskernels [-options]\n");
+            printf("Options:\n");
+            printf(" -csv         \t write comma separated values.\n");
+            printf(" -passes <n>  \t timed passes per kernel, the best is kept. (default 20)\n");
+            printf(" -kernel <name>\t run only the named kernel.\n");
+            exit(1);
+        }
+    }
+
+    if(passes < 1)
+        passes = 1;
+
+    /* Render at 16 bits so remap_8_to_16() has somewhere to write */
+    option.video_depth = 16;
+
+    if(!make_rom(rom_name))
+    {
+        printf("Error creating `%s'.\n", rom_name);
+        exit(1);
+    }
+
+    n = headless_init(rom_name);
+    unlink(rom_name);
+
+    if(!n)
+    {
+        printf("Error starting the console.\n");
+        exit(1);
+    }
+
+    sample_buffer[0] = calloc(SAMPLES, sizeof(int16));
+    sample_buffer[1] = calloc(SAMPLES, sizeof(int16));
+    if(!sample_buffer[0] || !sample_buffer[1])
+        exit(1);
+
+    vdp_fill();
+    sound_setup();
+
+    if(csv)
+        printf("kernel,unit,units,cycles_per_unit,ns_per_unit\n");
+    else
+        printf("%-26s %10s %-6s %12s %12s\n", "kernel", "units", "unit", "cycles/unit", "ns/unit");
+
+    for(i = 0; kernel[i].name; i++)
+    {
+        if(!only || strcmp(only, kernel[i].name) == 0)
+            bench(&kernel[i]);
+    }
+
+    OPLL_delete(opll);
+    YM2413Shutdown();
+    free(sample_buffer[0]);
+    free(sample_buffer[1]);
+    headless_shutdown();
+    return 0;
+}
@@ -0,0 +1,291 @@
+/*
+    latency.c --
+    Input-to-output latency measurement.
+
+    A game is run twice from power-on. The second run presses a button at
+    a chosen frame; because emulation is deterministic, the first place
+    where its display or sound output differs from the untouched run is
+    the first observable reaction to the input.
+*/
+
+#include "osd.h"
+#include <limits.h>
+
+/* Output of one frame of the reference run */
+typedef struct
+{
+    int height;
+    uint32 line[0x100];
+    int16 *sample[2];
+} t_frame_out;
+
+/* First difference found, in frames after the press and scanline */
+typedef struct
+{
+    int frame;
+    int line;
+} t_change;
+
+static int press_frame = 120;
+static int watch_frames = 60;
+static uint32 press_mask = INPUT_BUTTON1;
+
+
+static void hash_lines(t_frame_out *out)
+{
+    int y;
+    int bpp = bitmap.depth >> 3;
+
+    out->height = bitmap.viewport.h;
+
+    for(y = 0; y < bitmap.viewport.h; y++)
+    {
+        uint8 *src = &bitmap.data[(y + bitmap.viewport.y) * bitmap.pitch];
+        out->line[y] = crc32(0, src + bitmap.viewport.x * bpp, bitmap.viewport.w * bpp);
+    }
+}
+
+
+/* Scanline during which a given sample of the frame was generated */
+static int sample_line(int sample)
+{
+    int lines = (sms.display == DISPLAY_NTSC) ? 262 : 313;
+    return sample * lines / snd.sample_count;
+}
+
+
+/*
+    Run a game for press + watch frames. With no reference, the output
+    of every watched frame is recorded into 'ref'; otherwise the button
+    is held from the press frame on and the output compared against it.
+*/
+static int run_game(char *rom, int press, uint32 mask, t_frame_out *ref, int record,
+    t_change *video, t_change *audio)
+{
+    int i, ch;
+
+    if(!headless_init(rom))
+        return 0;
+
+    video->frame = audio->frame = -1;
+
+    for(i = 0; i < press + watch_frames; i++)
+    {
+        t_frame_out cur, *out;
+        int n = i - press;
+
+        input.pad[0] = (!record && n >= 0) ? mask : 0;
+        system_frame(0);
+
+        if(n < 0)
+            continue;
+
+        out = record ? &ref[n] : &cur;
+        hash_lines(out);
+
+        if(record)
+        {
+            for(ch = 0; ch < 2; ch++)
+            {
+                out->sample[ch] = malloc(snd.sample_count * sizeof(int16));
+                if(out->sample[ch] && snd.enabled)
+                    memcpy(out->sample[ch], snd.output[ch], snd.sample_count * sizeof(int16));
+                else
+                if(out->sample[ch])
+                    memset(out->sample[ch], 0, snd.sample_count * sizeof(int16));
+            }
+            continue;
+        }
+
+        if(video->frame < 0)
+        {
+            int y;
+
+            for(y = 0; y < cur.height; y++)
+            {
+                if(y >= ref[n].height || cur.line[y] != ref[n].line[y])
+                {
+                    video->frame = n;
+                    video->line = y;
+                    break;
+                }
+            }
+        }
+
+        if(audio->frame < 0 && snd.enabled)
+        {
+            int s, first = snd.sample_count;
+
+            for(ch = 0; ch < 2; ch++)
+            {
+                if(!ref[n].sample[ch])
+                    continue;
+                for(s = 0; s < first; s++)
+                {
+                    if(snd.output[ch][s] != ref[n].sample[ch][s])
+                    {
+                        first = s;
+                        break;
+                    }
+                }
+            }
+
+            if(first < snd.sample_count)
+            {
+                audio->frame = n;
+                audio->line = sample_line(first);
+            }
+        }
+
+        if(video->frame >= 0 && (audio->frame >= 0 || !snd.enabled))
+            break;
+    }
+
+    headless_shutdown();
+    return 1;
+}
+
+
+static void print_change(t_change *c)
+{
+    if(c->frame < 0)
+        printf("  %6s %5s", "-", "-");
+    else
+        printf("  %6d %5d", c->frame, c->line);
+}
+
+
+static int measure(char *rom, int press, uint32 mask)
+{
+    t_frame_out *ref;
+    t_change video, audio;
+    int i, ok;
+
+    ref = calloc(watch_frames, sizeof(t_frame_out));
+    if(!ref)
+        return 0;
+
+    ok = run_game(rom, press, mask, ref, 1, &video, &audio) &&
+         run_game(rom, press, mask, ref, 0, &video, &audio);
+
+    if(ok)
+    {
+        char *base = strrchr(rom, '/');
+        base = base ? base + 1 : rom;
+
+        printf("%-32.32s %6d %02X", base, press, mask);
+        print_change(&video);
+        print_change(&audio);
+        printf("\n");
+    }
+    else
+        printf("%-32.32s can't load game.\n", rom);
+
+    for(i = 0; i < watch_frames; i++)
+    {
+        free(ref[i].sample[0]);
+        free(ref[i].sample[1]);
+    }
+    free(ref);
+
+    return ok;
+}
+
+
+int main(int argc, char **argv)
+{
+    char line[PATH_MAX * 2];
+    FILE *fd;
+    int i, n, failed = 0;
+
+    /* Show usage if no arguments are specified */
+    if(argc < 2)
+    {
+        printf("\n%s input latency tool\n", APP_NAME);
+        printf("Version %s, build date: %s, %s\n", APP_VERSION, __DATE__, __TIME__);
+        printf("Usage: smslatency <listfile> [-options]\n");
+        printf("List file lines: <rom> [<frame> [<pad mask>]]\n");
+        printf("Options:\n");
+        printf(" -frame <n>   \t frame to press the button at. (default: 120)\n");
+        printf(" -pad <mask>  \t input.pad[0] bits to press, in hex. (default: 20, button 1)\n");
+        printf(" -watch <n>   \t frames to watch for a change. (default: 60)\n");
+        printf(" -sndrate <n> \t specify sound rate. (8000-48000)\n");
+        printf(" -depth <n>   \t specify color depth. (8, 16)\n");
+        printf(" -fm          \t enable YM2413 sound.\n");
+        printf(" -jp          \t use Japanese console type.\n");
+        printf(" -codies      \t force Codemasters mapper.\n");
+        printf(" -console <name>\t sms, smsj, sms2, gg, ggms, md, mdpbc, gen or genpbc.\n");
+        printf(" -hacks <file>\t speed hack database. (default: hacks.txt)\n");
+        printf(" -nohacks     \t don't use speed hacks.\n");
+        printf(" -overclock <n>\t give the Z80 n hidden lines each frame. (0-262)\n");
+        printf(" -core <name> \t Z80 core: default, exact, fast or lean.\n");
+        exit(1);
+    }
+
+    set_option_defaults();
+
+    for(i = 2; i < argc; i += n)
+    {
+        if(strcmp(argv[i], "-frame") == 0 && i + 1 < argc)
+        {
+            press_frame = atoi(argv[i + 1]);
+            n = 2;
+        }
+        else
+        if(strcmp(argv[i], "-pad") == 0 && i + 1 < argc)
+        {
+            press_mask = strtoul(argv[i + 1], NULL, 16);
+            n = 2;
+        }
+        else
+        if(strcmp(argv[i], "-watch") == 0 && i + 1 < argc)
+        {
+            watch_frames = atoi(argv[i + 1]);
+            n = 2;
+        }
+        else
+        if((n = parse_option(argc, argv, i)) == 0)
+        {
+            printf("Unknown option `%s'.\n", argv[i]);
+            exit(1);
+        }
+    }
+
+    if(press_frame < 0)
+        press_frame = 0;
+    if(watch_frames < 1)
+        watch_frames = 1;
+
+    /* Both outputs are compared */
+    option.render = 1;
+    option.sound = 1;
+
+    fd = fopen(argv[1], "r");
+    if(!fd)
+    {
+        printf("Error loading list `%s'.\n", argv[1]);
+        exit(1);
+    }
+
+    printf("%-32s %6s %-2s  %6s %5s  %6s %5s\n", "", "", "", "video", "", "audio", "");
+    printf("%-32s %6s %-2s  %6s %5s  %6s %5s\n", "rom", "press", "pad", "frames", "line", "frames", "line");
+
+    while(fgets(line, sizeof(line), fd))
+    {
+        char rom[PATH_MAX];
+        int press = press_frame;
+        unsigned int mask = press_mask;
+
+        if(line[0] == '#')
+            continue;
+
+        if(sscanf(line, "%4095s %d %x", rom, &press, &mask) < 1)
+            continue;
+
+        if(!measure(rom, press < 0 ? 0 : press, mask))
+            failed++;
+    }
+
+    fclose(fd);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,255 @@
+/*
+    main.c --
+    Headless frame throughput benchmark for Linux.
+*/
+
+#include "osd.h"
+#include <pthread.h>
+
+typedef struct
+{
+    pthread_t id;
+    int ok;
+    double elapsed;
+} t_bench;
+
+static char *rom_name;
+static int frames = 3600;
+
+
+/* Run one console to completion on its own thread */
+static void *bench_thread(void *arg)
+{
+    t_bench *b = (t_bench *)arg;
+    instance_config_t config;
+    instance_t *inst;
+    double start;
+    int i;
+
+    headless_config(&config);
+    inst = instance_create(rom_name, &config);
+    if(!inst)
+        return NULL;
+
+    start = headless_time();
+
+    for(i = 0; i < frames; i++)
+    {
+        instance_frame(inst, option.render ? 0 : 1);
+    }
+
+    b->elapsed = headless_time() - start;
+    b->ok = 1;
+
+    instance_destroy(inst);
+    return NULL;
+}
+
+
+/* Run several consoles side by side and report the aggregate rate */
+static int bench_threads(int count)
+{
+    t_bench *b = calloc(count, sizeof(t_bench));
+    double start, elapsed, slowest = 0.0;
+    int i, done = 0;
+
+    if(!b)
+        return 0;
+
+    start = headless_time();
+
+    for(i = 0; i < count; i++)
+    {
+        if(pthread_create(&b[i].id, NULL, bench_thread, &b[i]) != 0)
+            count = i;
+    }
+
+    for(i = 0; i < count; i++)
+    {
+        pthread_join(b[i].id, NULL);
+        if(b[i].ok)
+        {
+            done++;
+            if(b[i].elapsed > slowest)
+                slowest = b[i].elapsed;
+        }
+    }
+
+    elapsed = headless_time() - start;
+
+    if(done)
+    {
+        printf("game:      %s\n", rom_name);
+        printf("instances: %d threads x %d frames (render %s, sound %s)\n", done, frames,
+            option.render ? "on" : "off", option.sound ? "on" : "off");
+        printf("time:      %.3f s\n", elapsed);
+        printf("fps:       %.1f total, %.1f per instance (slowest)\n",
+            (double)done * frames / elapsed, frames / slowest);
+        printf("ns/frame:  %.0f\n", elapsed * 1e9 / ((double)done * frames));
+        printf("peak rss:  %ld KB\n", headless_peak_rss());
+    }
+
+    free(b);
+    return done;
+}
+
+
+/* Show where the recent frames spent their time (needs -DSTATS) */
+static void print_stats(void)
+{
+    stats_summary_t s;
+    stats_frame_t f;
+    int i;
+
+    if(!stats_summary(&s) || !stats_get(&f))
+        return;
+
+    printf("\nphase      calls/frame      p50 us      p90 us      p99 us      max us\n");
+    for(i = 0; i < STATS_MAX; i++)
+    {
+        printf("%-10s %11u %11.1f %11.1f %11.1f %11.1f\n", stats_name(i), f.calls[i],
+            s.p50[i] / 1000.0, s.p90[i] / 1000.0, s.p99[i] / 1000.0, s.max[i] / 1000.0);
+    }
+    printf("(last %d frames)\n", s.frames);
+}
+
+
+int main(int argc, char **argv)
+{
+    int threads = 1;
+    char *trace_name = NULL;
+    char *profile_name = NULL;
+    int i, n;
+    double start, elapsed;
+
+    /* Show usage if no arguments are specified */
+    if(argc < 2)
+    {
+        printf("\n%s headless benchmark\n", APP_NAME);
+        printf("Version %s, build date: %s, %s\n", APP_VERSION, __DATE__, __TIME__);
+        printf("Usage: smsbench <filename.ext> [-options]\n");
+        printf("Options:\n");
+        printf(" -frames <n>  \t number of frames to run. (default 3600)\n");
+        printf(" -threads <n> \t run <n> independent consoles in parallel.\n");
+        printf(" -trace <file>\t write a trace of every scanline. (needs -DTRACE)\n");
+        printf(" -profile <file>\t write a callgrind profile of the game. (needs -DZ80_PROFILE)\n");
+        printf(" -norender    \t skip rendering.\n");
+        printf(" -nosound     \t disable sound emulation.\n");
+        printf(" -sndrate <n> \t specify sound rate. (8000-48000)\n");
+        printf(" -depth <n>   \t specify color depth. (8, 16)\n");
+        printf(" -fm          \t enable YM2413 sound.\n");
+        printf(" -jp          \t use Japanese console type.\n");
+        printf(" -codies      \t force Codemasters mapper.\n");
+        printf(" -console <name>\t sms, smsj, sms2, gg, ggms, md, mdpbc, gen or genpbc.\n");
+        printf(" -hacks <file>\t speed hack database. (default: hacks.txt)\n");
+        printf(" -nohacks     \t don't use speed hacks.\n");
+        printf(" -overclock <n>\t give the Z80 n hidden lines each frame. (0-262)\n");
+        printf(" -core <name> \t Z80 core: default, exact, fast or lean.\n");
+        exit(1);
+    }
+
+    set_option_defaults();
+    rom_name = argv[1];
+
+    for(i = 2; i < argc; i += n)
+    {
+        if(strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+        {
+            frames = atoi(argv[i + 1]);
+            n = 2;
+        }
+        else
+        if(strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+        {
+            threads = atoi(argv[i + 1]);
+            n = 2;
+        }
+        else
+        if(strcmp(argv[i], "-trace") == 0 && i + 1 < argc)
+        {
+            trace_name = argv[i + 1];
+            n = 2;
+        }
+        else
+        if(strcmp(argv[i], "-profile") == 0 && i + 1 < argc)
+        {
+            profile_name = argv[i + 1];
+            n = 2;
+        }
+        else
+        if((n = parse_option(argc, argv, i)) == 0)
+        {
+            printf("Unknown option `%s'.\n", argv[i]);
+            exit(1);
+        }
+    }
+
+    if(frames <= 0)
+        frames = 1;
+
+    if(threads > 1)
+    {
+        if(bench_threads(threads) == 0)
+        {
+            printf("Error loading `%s'.\n", rom_name);
+            exit(1);
+        }
+        return 0;
+    }
+
+    if(headless_init(rom_name) == 0)
+    {
+        printf("Error loading `%s'.\n", rom_name);
+        exit(1);
+    }
+
+    if(trace_name && !trace_open(trace_name, TRACE_MASK_ALL))
+    {
+        printf("Error opening trace file `%s'.\n", trace_name);
+        exit(1);
+    }
+
+    if(profile_name && !profile_start())
+    {
+        printf("Profiler not available, rebuild with -DZ80_PROFILE.\n");
+        exit(1);
+    }
+
+    start = headless_time();
+
+    for(i = 0; i < frames; i++)
+    {
+        system_frame(option.render ? 0 : 1);
+    }
+
+    elapsed = headless_time() - start;
+
+    trace_close();
+    profile_stop();
+
+    printf("game:      %s (crc %08X, %s)\n", game_name, cart.crc,
+        (sms.display == DISPLAY_NTSC) ? "NTSC" : "PAL");
+    printf("frames:    %d (render %s, sound %s)\n", frames,
+        option.render ? "on" : "off", snd.enabled ? "on" : "off");
+    printf("time:      %.3f s\n", elapsed);
+    printf("fps:       %.1f\n", frames / elapsed);
+    printf("ns/frame:  %.0f\n", elapsed * 1e9 / frames);
+    printf("lag:       %u frames without input reads (%.1f%%)\n", lag.frames,
+        100.0 * lag.frames / frames);
+    printf("peak rss:  %ld KB\n", headless_peak_rss());
+    print_stats();
+
+    if(profile_name)
+    {
+        if(!profile_write_callgrind(profile_name, game_name))
+            printf("Error writing profile `%s'.\n", profile_name);
+
+        printf("\n");
+        profile_write_hot(stdout, 20);
+        printf("\n");
+        profile_write_opcodes(stdout, 20);
+    }
+
+    headless_shutdown();
+    return 0;
+}
@@ -0,0 +1,16 @@
+
+#ifndef _OSD_H_
+#define _OSD_H_
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include "shared.h"
+#include "headless.h"
+
+#endif /* _OSD_H_ */
@@ -0,0 +1,404 @@
+/*
+    regress.c --
+    Golden frame and audio hash regression suite.
+
+    Every frame of every listed game is hashed (the visible part of the
+    display and both sound channels) and checked against the goldens
+    recorded earlier, along with the time taken per frame.
+*/
+
+#include "osd.h"
+#include <limits.h>
+
+/* Hashes of one frame */
+typedef struct
+{
+    uint32 video;
+    uint32 audio;
+    uint8 mode;
+    uint8 height;
+} t_frame_hash;
+
+typedef struct
+{
+    uint32 crc;
+    int frames;
+    double ns_frame;
+    t_frame_hash *hash;
+} t_run;
+
+static char *golden_dir = "golden";
+static int record = 0;
+static double slow_limit = 5.0;
+static int state_every = 0;
+
+
+static const char *mode_name(uint8 mode, uint8 height)
+{
+    static char buf[0x20];
+    static const char *tms_name[] = {
+        "Graphics I",
+        "Text",
+        "Graphics II",
+        "Text (Extended PG)",
+        "Multicolor",
+        "Invalid (1+3)",
+        "Multicolor (Extended PG)",
+        "Invalid (1+2+3)",
+    };
+
+    if(mode & 8)
+    {
+        sprintf(buf, "Mode 4 (%d lines)", height);
+        return buf;
+    }
+
+    return tms_name[mode & 7];
+}
+
+
+/* Run a game and hash every frame */
+static int run_game(char *rom, int frames, char *script_name, t_run *run)
+{
+    t_input_script script;
+    double elapsed = 0.0;
+    uint8 *state = NULL;
+    int i;
+
+    memset(run, 0, sizeof(t_run));
+
+    if(!script_load(&script, script_name))
+    {
+        printf("%s: can't load input script `%s'.\n", rom, script_name);
+        return 0;
+    }
+
+    if(!headless_init(rom))
+    {
+        printf("%s: can't load game.\n", rom);
+        script_free(&script);
+        return 0;
+    }
+
+    run->hash = malloc(frames * sizeof(t_frame_hash));
+    if(state_every)
+        state = malloc(get_save_state_size());
+    if(!run->hash || (state_every && !state))
+    {
+        free(run->hash);
+        free(state);
+        headless_shutdown();
+        script_free(&script);
+        return 0;
+    }
+
+    run->crc = cart.crc;
+    run->frames = frames;
+
+    for(i = 0; i < frames; i++)
+    {
+        double start;
+
+        script_apply(&script, i);
+
+        /* Go through a saved state, which must not change the output */
+        if(state_every && i > 0 && (i % state_every) == 0)
+        {
+            save_state_to_mem(state);
+            load_state_from_mem(state);
+        }
+
+        start = headless_time();
+        system_frame(0);
+        elapsed += headless_time() - start;
+
+        run->hash[i].video  = video_crc(0);
+        run->hash[i].audio  = audio_crc(0);
+        run->hash[i].mode   = vdp.mode;
+        run->hash[i].height = vdp.height;
+    }
+
+    run->ns_frame = elapsed * 1e9 / frames;
+
+    free(state);
+    headless_shutdown();
+    script_free(&script);
+    return 1;
+}
+
+
+static void golden_name(char *buf, char *rom)
+{
+    char *base = strrchr(rom, '/');
+    base = base ? base + 1 : rom;
+    snprintf(buf, PATH_MAX * 2, "%s/%s.golden", golden_dir, base);
+}
+
+
+static int golden_save(char *rom, t_run *run)
+{
+    char name[PATH_MAX * 2];
+    FILE *fd;
+    int i;
+
+    golden_name(name, rom);
+    fd = fopen(name, "w");
+    if(!fd)
+        return 0;
+
+    fprintf(fd, "# frame video audio mode height\n");
+    fprintf(fd, "crc %08X frames %d ns %.0f\n", run->crc, run->frames, run->ns_frame);
+
+    for(i = 0; i < run->frames; i++)
+    {
+        fprintf(fd, "%d %08X %08X %02X %d\n", i,
+            run->hash[i].video, run->hash[i].audio,
+            run->hash[i].mode, run->hash[i].height);
+    }
+
+    fclose(fd);
+    return 1;
+}
+
+
+static int golden_load(char *rom, t_run *run)
+{
+    char name[PATH_MAX * 2], line[0x100];
+    FILE *fd;
+    int count = 0;
+
+    memset(run, 0, sizeof(t_run));
+
+    golden_name(name, rom);
+    fd = fopen(name, "r");
+    if(!fd)
+        return 0;
+
+    while(fgets(line, sizeof(line), fd))
+    {
+        unsigned int video, audio, mode, crc;
+        int frame, height, frames;
+        double ns;
+
+        if(line[0] == '#')
+            continue;
+
+        if(sscanf(line, "crc %x frames %d ns %lf", &crc, &frames, &ns) == 3)
+        {
+            if(run->hash || frames <= 0)
+                break;
+            run->crc = crc;
+            run->frames = frames;
+            run->ns_frame = ns;
+            run->hash = calloc(frames, sizeof(t_frame_hash));
+            if(!run->hash)
+                break;
+            continue;
+        }
+
+        if(!run->hash || sscanf(line, "%d %x %x %x %d", &frame, &video, &audio, &mode, &height) != 5)
+            continue;
+
+        if(frame < 0 || frame >= run->frames)
+            continue;
+
+        run->hash[frame].video  = video;
+        run->hash[frame].audio  = audio;
+        run->hash[frame].mode   = mode;
+        run->hash[frame].height = height;
+        count++;
+    }
+
+    fclose(fd);
+
+    if(!run->hash || count != run->frames)
+    {
+        free(run->hash);
+        run->hash = NULL;
+        return 0;
+    }
+
+    return 1;
+}
+
+
+/* Compare a run against its golden, returns non-zero if they match */
+static int compare(char *rom, t_run *cur, t_run *gold)
+{
+    double delta = 100.0 * (cur->ns_frame - gold->ns_frame) / gold->ns_frame;
+    int i, first = -1, bad = 0;
+
+    if(cur->crc != gold->crc)
+    {
+        printf("%-32s FAIL  game crc %08X, golden %08X\n", rom, cur->crc, gold->crc);
+        return 0;
+    }
+
+    for(i = 0; i < cur->frames && i < gold->frames; i++)
+    {
+        if(cur->hash[i].video != gold->hash[i].video ||
+           cur->hash[i].audio != gold->hash[i].audio)
+        {
+            if(first < 0)
+                first = i;
+            bad++;
+        }
+    }
+
+    printf("%-32s %s  %8.0f ns/frame (golden %.0f, %+.1f%%)%s\n", rom,
+        first < 0 ? "ok  " : "FAIL", cur->ns_frame, gold->ns_frame, delta,
+        delta > slow_limit ? " SLOWER" : "");
+
+    if(first >= 0)
+    {
+        t_frame_hash *c = &cur->hash[first];
+        t_frame_hash *g = &gold->hash[first];
+
+        printf("    first difference at frame %d (%s%s%s), %d of %d frames differ\n",
+            first,
+            c->video != g->video ? "video" : "",
+            c->video != g->video && c->audio != g->audio ? " and " : "",
+            c->audio != g->audio ? "audio" : "",
+            bad, cur->frames);
+        printf("    VDP mode: %s", mode_name(c->mode, c->height));
+        printf(", golden %s\n", mode_name(g->mode, g->height));
+    }
+
+    return (first < 0);
+}
+
+
+int main(int argc, char **argv)
+{
+    char line[PATH_MAX * 2];
+    FILE *fd;
+    int i, n;
+    int passed = 0, failed = 0, missing = 0;
+
+    /* Show usage if no arguments are specified */
+    if(argc < 2)
+    {
+        printf("\n%s regression suite\n", APP_NAME);
+        printf("Version %s, build date: %s, %s\n", APP_VERSION, __DATE__, __TIME__);
+        printf("Usage: smsregress <listfile> [-options]\n");
+        printf("List file lines: <rom> <frames> [<script>]\n");
+        printf("Options:\n");
+        printf(" -record      \t write new goldens instead of checking.\n");
+        printf(" -golden <dir>\t directory holding the goldens. (default: golden)\n");
+        printf(" -slow <pct>  \t flag games slower than the golden by this much. (default 5)\n");
+        printf(" -state <n>   \t save and reload the state every n frames.\n");
+        printf(" -sndrate <n> \t specify sound rate. (8000-48000)\n");
+        printf(" -depth <n>   \t specify color depth. (8, 16)\n");
+        printf(" -fm          \t enable YM2413 sound.\n");
+        printf(" -jp          \t use Japanese console type.\n");
+        printf(" -codies      \t force Codemasters mapper.\n");
+        printf(" -console <name>\t sms, smsj, sms2, gg, ggms, md, mdpbc, gen or genpbc.\n");
+        printf(" -hacks <file>\t speed hack database. (default: hacks.txt)\n");
+        printf(" -nohacks     \t don't use speed hacks.\n");
+        printf(" -overclock <n>\t give the Z80 n hidden lines each frame. (0-262)\n");
+        printf(" -core <name> \t Z80 core: default, exact, fast or lean.\n");
+        exit(1);
+    }
+
+    set_option_defaults();
+
+    for(i = 2; i < argc; i += n)
+    {
+        if(strcmp(argv[i], "-record") == 0)
+        {
+            record = 1;
+            n = 1;
+        }
+        else
+        if(strcmp(argv[i], "-golden") == 0 && i + 1 < argc)
+        {
+            golden_dir = argv[i + 1];
+            n = 2;
+        }
+        else
+        if(strcmp(argv[i], "-slow") == 0 && i + 1 < argc)
+        {
+            slow_limit = atof(argv[i + 1]);
+            n = 2;
+        }
+        else
+        if(strcmp(argv[i], "-state") == 0 && i + 1 < argc)
+        {
+            state_every = atoi(argv[i + 1]);
+            n = 2;
+        }
+        else
+        if((n = parse_option(argc, argv, i)) == 0)
+        {
+            printf("Unknown option `%s'.\n", argv[i]);
+            exit(1);
+        }
+    }
+
+    /* Goldens always cover both video and audio */
+    option.render = 1;
+    option.sound = 1;
+
+    fd = fopen(argv[1], "r");
+    if(!fd)
+    {
+        printf("Error loading list `%s'.\n", argv[1]);
+        exit(1);
+    }
+
+    while(fgets(line, sizeof(line), fd))
+    {
+        char rom[PATH_MAX], script[PATH_MAX];
+        int frames;
+        t_run cur, gold;
+
+        if(line[0] == '#')
+            continue;
+
+        strcpy(script, "-");
+        if(sscanf(line, "%4095s %d %4095s", rom, &frames, script) < 2 || frames <= 0)
+            continue;
+
+        if(!run_game(rom, frames, script, &cur))
+        {
+            failed++;
+            continue;
+        }
+
+        if(record)
+        {
+            if(golden_save(rom, &cur))
+            {
+                printf("%-32s recorded %d frames, %.0f ns/frame\n", rom, frames, cur.ns_frame);
+                passed++;
+            }
+            else
+            {
+                printf("%-32s can't write golden in `%s'.\n", rom, golden_dir);
+                failed++;
+            }
+        }
+        else
+        if(!golden_load(rom, &gold) || gold.frames != frames)
+        {
+            printf("%-32s no golden for %d frames\n", rom, frames);
+            free(gold.hash);
+            missing++;
+        }
+        else
+        {
+            if(compare(rom, &cur, &gold))
+                passed++;
+            else
+                failed++;
+            free(gold.hash);
+        }
+
+        free(cur.hash);
+    }
+
+    fclose(fd);
+
+    printf("\n%d passed, %d failed, %d missing\n", passed, failed, missing);
+    return (failed || missing) ? 1 : 0;
+}
@@ -0,0 +1,658 @@
+/*
+    testrom.c --
+    Test ROM generator.
+
+    Writes the homebrew ROMs checked by the regression suite in tests/.
+    Each one drives a part of the emulator that games only reach in
+    passing, and makes the outcome visible: the first 1K of work RAM,
+    where the ROMs keep their results, is copied to the first 32 tiles
+    every frame, and the name table shows those tiles in the part of
+    the screen both the SMS and the GG display.
+
+    The ROMs are built by a small assembler so that they can be kept as
+    source; 'make -f makefile.linux check' writes them to tests/roms and
+    runs smsregress against the goldens in tests/golden.
+*/
+
+#include "osd.h"
+#include <limits.h>
+
+#define MAX_LABELS      0x40
+#define MAX_FIXUPS      0x100
+
+/* Work RAM copied to the screen by SHOW */
+#define RESULTS         0xC000
+#define IRQ_D           0xC3FD
+#define IRQ_B           0xC3FE
+#define IRQ_COUNT       0xC3FF
+
+/* A reference to a label, resolved when the ROM is written */
+typedef struct
+{
+    int at;
+    int label;
+    int relative;
+} t_fixup;
+
+enum
+{
+    L_INIT, L_MAIN, L_SHOW, L_SHOW_LOOP, L_REGS, L_ROW, L_COL, L_CRAM,
+    L_VRAM, L_OUTI, L_PSG, L_SELF, L_SELF_DATA, L_LONG, L_PORT, L_PORT_SKIP,
+};
+
+static uint8 *rom;
+static int rom_size;
+static int pc;
+static int label_addr[MAX_LABELS];
+static t_fixup fixup[MAX_FIXUPS];
+static int fixups;
+static int result_ptr;
+
+static uint32 seed = 1;
+
+
+static uint8 random8(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) & 0xFF;
+}
+
+
+/*--------------------------------------------------------------------------*/
+/* Assembler                                                                */
+/*--------------------------------------------------------------------------*/
+
+static void begin(int size)
+{
+    rom = calloc(1, size);
+    if(!rom)
+    {
+        printf("Out of memory.\n");
+        exit(1);
+    }
+
+    rom_size = size;
+    pc = 0;
+    fixups = 0;
+    result_ptr = RESULTS;
+    memset(label_addr, 0xFF, sizeof(label_addr));
+}
+
+
+static void org(int address)
+{
+    /* Blocks are placed in order, so this catches code running over */
+    if(address < pc)
+    {
+        printf("Code at $%04X runs into $%04X.\n", pc, address);
+        exit(1);
+    }
+    pc = address;
+}
+
+
+static void db(const int *data, int count)
+{
+    while(count--)
+        rom[pc++] = *data++ & 0xFF;
+}
+
+#define DB(...)     db((const int []){ __VA_ARGS__ }, \
+                        sizeof((const int []){ __VA_ARGS__ }) / sizeof(int))
+
+
+static void dw(int data)
+{
+    DB(data, data >> 8);
+}
+
+
+static void label(int n)
+{
+    label_addr[n] = pc;
+}
+
+
+static void ref(int n)
+{
+    fixup[fixups].at = pc;
+    fixup[fixups].label = n;
+    fixup[fixups].relative = 0;
+    fixups++;
+    dw(0);
+}
+
+
+/* A relative jump (JR, JR cc or DJNZ) to a label */
+static void jr(int opcode, int n)
+{
+    DB(opcode);
+    fixup[fixups].at = pc;
+    fixup[fixups].label = n;
+    fixup[fixups].relative = 1;
+    fixups++;
+    DB(0);
+}
+
+
+static void save(char *dir, char *name)
+{
+    char path[PATH_MAX];
+    FILE *fd;
+    int i;
+
+    for(i = 0; i < fixups; i++)
+    {
+        t_fixup *f = &fixup[i];
+        int target = label_addr[f->label];
+
+        if(f->relative)
+        {
+            int offset = target - (f->at + 1);
+            if(offset < -128 || offset > 127)
+            {
+                printf("%s: jump at $%04X out of range.\n", name, f->at - 1);
+                exit(1);
+            }
+            rom[f->at] = offset & 0xFF;
+        }
+        else
+        {
+            rom[f->at] = target & 0xFF;
+            rom[f->at + 1] = (target >> 8) & 0xFF;
+        }
+    }
+
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    fd = fopen(path, "wb");
+    if(!fd || fwrite(rom, rom_size, 1, fd) != 1)
+    {
+        printf("Can't write `%s'.\n", path);
+        exit(1);
+    }
+    fclose(fd);
+    free(rom);
+
+    printf("%s\n", path);
+}
+
+
+/*--------------------------------------------------------------------------*/
+/* Common code                                                              */
+/*--------------------------------------------------------------------------*/
+
+/* Point the VDP at an address (0x4000 set for writes, 0xC000 for CRAM) */
+static void vdp_address(int address)
+{
+    DB(0x3E, address, 0xD3, 0xBF);         /* LD A,lo; OUT ($BF),A */
+    DB(0x3E, address >> 8, 0xD3, 0xBF);    /* LD A,hi; OUT ($BF),A */
+}
+
+
+/* Record R, the V counter, B and HL in the next result slot */
+static void result(void)
+{
+    DB(0xED, 0x5F, 0x32); dw(result_ptr);  /* LD A,R; LD (nn),A */
+    DB(0xDB, 0x7E, 0x32); dw(result_ptr + 1); /* IN A,($7E); LD (nn),A */
+    DB(0x78, 0x32); dw(result_ptr + 2);    /* LD A,B; LD (nn),A */
+    DB(0x22); dw(result_ptr + 3);          /* LD (nn),HL */
+    result_ptr += 5;
+}
+
+
+/*
+    Reset and interrupt handlers, VDP set-up and the SHOW subroutine.
+    The frame interrupt counts frames and records B and D, so a ROM can
+    see where in a loop it was taken. SHOW waits for the next frame and
+    copies the results to the screen; everything else runs with
+    interrupts disabled unless a ROM enables them itself.
+*/
+static void common(void)
+{
+    static const int regs[] = {
+        0x06, 0x80, 0xE0, 0x81, 0xFF, 0x82, 0xFF, 0x83, 0xFF, 0x84,
+        0xFF, 0x85, 0xFB, 0x86, 0x00, 0x87, 0x00, 0x88, 0x00, 0x89,
+        0xFF, 0x8A,
+    };
+    int i;
+
+    org(0x0000);
+    DB(0xF3);                               /* DI */
+    DB(0xED, 0x56);                         /* IM 1 */
+    DB(0x31); dw(0xDFF0);                   /* LD SP,$DFF0 */
+    DB(0xC3); ref(L_INIT);                  /* JP init */
+
+    org(0x0038);
+    DB(0xF5);                               /* PUSH AF */
+    DB(0xDB, 0xBF);                         /* IN A,($BF) */
+    DB(0x3A); dw(IRQ_COUNT);                /* LD A,(count) */
+    DB(0x3C);                               /* INC A */
+    DB(0x32); dw(IRQ_COUNT);                /* LD (count),A */
+    DB(0x78, 0x32); dw(IRQ_B);              /* LD A,B; LD (nn),A */
+    DB(0x7A, 0x32); dw(IRQ_D);              /* LD A,D; LD (nn),A */
+    DB(0xF1);                               /* POP AF */
+    DB(0xFB);                               /* EI */
+    DB(0xED, 0x4D);                         /* RETI */
+
+    org(0x0066);
+    DB(0xED, 0x45);                         /* RETN */
+
+    org(0x0080);
+    label(L_INIT);
+    DB(0x21); ref(L_REGS);                  /* LD HL,regs */
+    DB(0x06, sizeof(regs) / sizeof(int));   /* LD B,n */
+    DB(0x0E, 0xBF);                         /* LD C,$BF */
+    DB(0xED, 0xB3);                         /* OTIR */
+
+    /* Name table entry (row, column) is tile (row * 20 + column + 30)
+       & 31, which puts all 32 tiles in the GG's 20x18 window too */
+    vdp_address(0x7800);
+    DB(0x1E, 30);                           /* LD E,30 */
+    DB(0x16, 24);                           /* LD D,24 */
+    label(L_ROW);
+    DB(0x06, 32);                           /* LD B,32 */
+    DB(0x7B);                               /* LD A,E */
+    label(L_COL);
+    DB(0xF5);                               /* PUSH AF */
+    DB(0xE6, 0x1F, 0xD3, 0xBE);             /* AND $1F; OUT ($BE),A */
+    DB(0xAF, 0xD3, 0xBE);                   /* XOR A; OUT ($BE),A */
+    DB(0xF1, 0x3C);                         /* POP AF; INC A */
+    jr(0x10, L_COL);                        /* DJNZ col */
+    DB(0x7B, 0xC6, 20, 0x5F);               /* LD A,E; ADD A,20; LD E,A */
+    DB(0x15);                               /* DEC D */
+    jr(0x20, L_ROW);                        /* JR NZ,row */
+
+    /* 64 bytes of CRAM cover the GG palette */
+    vdp_address(0xC000);
+    DB(0x06, 0x40);                         /* LD B,$40 */
+    label(L_CRAM);
+    DB(0x78, 0xD3, 0xBE);                   /* LD A,B; OUT ($BE),A */
+    jr(0x10, L_CRAM);                       /* DJNZ cram */
+
+    /* No sprites */
+    vdp_address(0x7F00);
+    DB(0x3E, 0xD0, 0xD3, 0xBE);             /* LD A,$D0; OUT ($BE),A */
+    DB(0xC3); ref(L_MAIN);                  /* JP main */
+
+    label(L_SHOW);
+    DB(0xDB, 0xBF);                         /* IN A,($BF) */
+    DB(0xFB, 0x76, 0xF3);                   /* EI; HALT; DI */
+    vdp_address(0x4000);
+    DB(0x21); dw(RESULTS);                  /* LD HL,results */
+    DB(0x0E, 0xBE);                         /* LD C,$BE */
+    DB(0x16, 0x04);                         /* LD D,4 */
+    label(L_SHOW_LOOP);
+    DB(0x06, 0x00, 0xED, 0xB3);             /* LD B,0; OTIR */
+    DB(0x15);                               /* DEC D */
+    jr(0x20, L_SHOW_LOOP);                  /* JR NZ,loop */
+    DB(0xC9);                               /* RET */
+
+    label(L_REGS);
+    for(i = 0; i < sizeof(regs) / sizeof(int); i++)
+        DB(regs[i]);
+}
+
+
+/*--------------------------------------------------------------------------*/
+/* Block I/O                                                                */
+/*--------------------------------------------------------------------------*/
+
+/*
+    OTIR, INIR and OUTI runs to the VDP and PSG, for the block paths in
+    the Z80 core (otir_block, inir_block, outi_block). The runs start
+    and end on and across 1K pages, go from ROM into RAM, write the
+    mapper registers, overwrite the INIR doing the writing, and take a
+    frame interrupt part way through. After each one R, the V counter,
+    B and HL are recorded, so a wrong cycle or R count shows up, and
+    what an INIR read is copied to the screen.
+*/
+static void build_block(char *dir, char *name, uint32 rom_seed)
+{
+    int i;
+
+    begin(0x20000);
+    seed = rom_seed;
+    for(i = 0x1000; i < rom_size; i++)
+        rom[i] = random8();
+
+    common();
+
+    label(L_MAIN);
+    DB(0xCD); ref(L_SHOW);                  /* CALL show */
+    DB(0x3A); dw(IRQ_COUNT);                /* LD A,(count) */
+    DB(0x5F);                               /* LD E,A */
+    result();
+
+    /* OTIRs of E bytes (256 if zero) from ROM, one after the other
+       through the 1K pages of slot 1, to VRAM $1000-$2FFF */
+    DB(0x7B, 0xD3, 0xBF);                   /* LD A,E; OUT ($BF),A */
+    DB(0x7B, 0xE6, 0x1F, 0xF6, 0x50);       /* LD A,E; AND $1F; OR $50 */
+    DB(0xD3, 0xBF);                         /* OUT ($BF),A */
+    DB(0x26, 0x40, 0x6B);                   /* LD H,$40; LD L,E */
+    DB(0x0E, 0xBE);                         /* LD C,$BE */
+    DB(0x16, 0x06);                         /* LD D,6 */
+    label(L_VRAM);
+    DB(0x43, 0xED, 0xB3);                   /* LD B,E; OTIR */
+    DB(0x15);                               /* DEC D */
+    jr(0x20, L_VRAM);                       /* JR NZ,vram */
+    result();
+    DB(0x06, 0x00, 0xED, 0xB3);             /* LD B,0; OTIR */
+    result();
+
+    /* CRAM, wrapping round */
+    vdp_address(0xC000);
+    DB(0x21); dw(0x6000);                   /* LD HL,$6000 */
+    DB(0x06, 40, 0xED, 0xB3);               /* LD B,40; OTIR */
+    result();
+
+    /* A run of OUTIs that crosses a 1K page of code, reading across a
+       1K page of ROM */
+    DB(0x7B, 0xD3, 0xBF);                   /* LD A,E; OUT ($BF),A */
+    DB(0x3E, 0x60, 0xD3, 0xBF);             /* LD A,$60; OUT ($BF),A */
+    DB(0x21); dw(0x53F0);                   /* LD HL,$53F0 */
+    DB(0xCD); ref(L_OUTI);                  /* CALL outi */
+    result();
+
+    /* PSG */
+    DB(0x0E, 0x7F);                         /* LD C,$7F */
+    DB(0x21); ref(L_PSG);                   /* LD HL,psg */
+    DB(0x06, 12, 0xED, 0xB3);               /* LD B,12; OTIR */
+    for(i = 0; i < 6; i++)
+        DB(0xED, 0xA3);                     /* OUTI */
+    result();
+    DB(0x0E, 0xBE);                         /* LD C,$BE */
+
+    /* Read back what the first OTIRs wrote */
+    DB(0x7B, 0xD3, 0xBF);                   /* LD A,E; OUT ($BF),A */
+    DB(0x7B, 0xE6, 0x1F, 0xF6, 0x10);       /* LD A,E; AND $1F; OR $10 */
+    DB(0xD3, 0xBF);                         /* OUT ($BF),A */
+    DB(0x21); dw(0xC100);                   /* LD HL,$C100 */
+    DB(0x43, 0xED, 0xB2);                   /* LD B,E; INIR */
+    result();
+
+    /* INIR and OTIR across a 1K page of RAM */
+    DB(0x21); dw(0xC7F8);                   /* LD HL,$C7F8 */
+    DB(0x06, 0x30, 0xED, 0xB2);             /* LD B,$30; INIR */
+    result();
+    vdp_address(0x7000);
+    DB(0x21); dw(0xC7E0);                   /* LD HL,$C7E0 */
+    DB(0x06, 0x50, 0xED, 0xB3);             /* LD B,$50; OTIR */
+    result();
+
+    /* OTIR from the end of a ROM bank into RAM, read back to the
+       screen */
+    DB(0x7B, 0xE6, 0x07, 0x32); dw(0xFFFF); /* LD A,E; AND 7; LD ($FFFF),A */
+    vdp_address(0x7000);
+    DB(0x21); dw(0xBFF0);                   /* LD HL,$BFF0 */
+    DB(0x06, 0x20, 0xED, 0xB3);             /* LD B,$20; OTIR */
+    result();
+    vdp_address(0x3000);
+    DB(0x21); dw(0xC200);                   /* LD HL,$C200 */
+    DB(0x06, 0x20, 0xED, 0xB2);             /* LD B,$20; INIR */
+    result();
+
+    /* INIR over the mapper registers: $FFFC-$FFFD are written as zero,
+       $FFFE-$FFFF get banks from E */
+    vdp_address(0x7E00);
+    for(i = 0; i < 4; i++)
+        DB(0x7B, 0xD3, 0xBE);               /* LD A,E; OUT ($BE),A */
+    DB(0xAF, 0xD3, 0xBE, 0xD3, 0xBE);       /* XOR A; OUT ($BE),A (x2) */
+    DB(0x7B, 0xE6, 0x07, 0xD3, 0xBE);       /* LD A,E; AND 7; OUT ($BE),A */
+    DB(0x7B, 0x0F, 0xE6, 0x07, 0xD3, 0xBE); /* LD A,E; RRCA; AND 7; OUT */
+    vdp_address(0x3E00);
+    DB(0x21); dw(0xFFF8);                   /* LD HL,$FFF8 */
+    DB(0x06, 0x08, 0xED, 0xB2);             /* LD B,8; INIR */
+    result();
+    DB(0x21); dw(0x7FF8);                   /* LD HL,$7FF8 */
+    DB(0x11); dw(RESULTS + 0xE0);           /* LD DE,nn */
+    DB(0x01); dw(0x0010);                   /* LD BC,$10 */
+    DB(0xED, 0xB0);                         /* LDIR */
+    DB(0x21); dw(0xBFF8);                   /* LD HL,$BFF8 */
+    DB(0x01); dw(0x0010);                   /* LD BC,$10 */
+    DB(0xED, 0xB0);                         /* LDIR */
+
+    /* An INIR in RAM that overwrites itself: on odd passes it writes
+       back the same opcode and runs to the end, on even passes a NOP
+       ends it early */
+    DB(0x21); ref(L_SELF);                  /* LD HL,self */
+    DB(0x11); dw(0xD100);                   /* LD DE,$D100 */
+    DB(0x01); dw(0x000A);                   /* LD BC,10 */
+    DB(0xED, 0xB0);                         /* LDIR */
+    vdp_address(0x7E10);
+    DB(0x7B, 0xE6, 0x01);                   /* LD A,E; AND 1 */
+    DB(0x0F, 0x0F, 0x0F);                   /* RRCA (x3), 0 or 32 */
+    DB(0x21); ref(L_SELF_DATA);             /* LD HL,data */
+    DB(0x85, 0x6F);                         /* ADD A,L; LD L,A */
+    DB(0x0E, 0xBE);                         /* LD C,$BE */
+    DB(0x06, 0x20, 0xED, 0xB3);             /* LD B,$20; OTIR */
+    vdp_address(0x3E10);
+    DB(0xCD); dw(0xD100);                   /* CALL $D100 */
+    result();
+    DB(0x0E, 0xBE);                         /* LD C,$BE */
+
+    /* A frame interrupt taken during one of 12 OTIRs, where it
+       records how far they had got */
+    vdp_address(0x6000);
+    DB(0x16, 12);                           /* LD D,12 */
+    DB(0xDB, 0xBF);                         /* IN A,($BF) */
+    DB(0xFB);                               /* EI */
+    label(L_LONG);
+    DB(0x06, 0x00, 0xED, 0xB3);             /* LD B,0; OTIR */
+    DB(0x15);                               /* DEC D */
+    jr(0x20, L_LONG);                       /* JR NZ,long */
+    DB(0xF3);                               /* DI */
+    DB(0x2A); dw(IRQ_D);                    /* LD HL,(d) */
+    DB(0x22); dw(result_ptr);               /* LD (nn),HL */
+    result_ptr += 2;
+    result();
+
+    DB(0xC3); ref(L_MAIN);                  /* JP main */
+
+    /* INIR copied to $D100, writing $D0F0-$D10F */
+    label(L_SELF);
+    DB(0x21); dw(0xD0F0);                   /* LD HL,$D0F0 */
+    DB(0x06, 0x20);                         /* LD B,$20 */
+    DB(0x0E, 0xBE);                         /* LD C,$BE */
+    DB(0xED, 0xB2);                         /* INIR */
+    DB(0xC9);                               /* RET */
+
+    label(L_PSG);
+    DB(0x83, 0x10, 0x92, 0xA5, 0x08, 0xB4, 0xC1, 0x20, 0xD6);
+    DB(0xE4, 0xF3, 0x9F, 0xBF, 0xDF, 0xFF, 0x81, 0x11, 0x92);
+
+    /* Both tables in one 256-byte page, as only L is adjusted */
+    org((pc + 0xFF) & ~0xFF);
+    label(L_SELF_DATA);
+    for(i = 0; i < 0x40; i++)
+        DB(random8());
+    rom[label_addr[L_SELF_DATA] + 0x17] = 0x00;
+    rom[label_addr[L_SELF_DATA] + 0x20 + 0x17] = 0xED;
+    rom[label_addr[L_SELF_DATA] + 0x20 + 0x18] = 0xB2;
+    rom[label_addr[L_SELF_DATA] + 0x20 + 0x19] = 0xC9;
+
+    org(0x0FC0);
+    label(L_OUTI);
+    for(i = 0; i < 70; i++)
+        DB(0xED, 0xA3);                     /* OUTI */
+    DB(0xC9);                               /* RET */
+
+    save(dir, name);
+}
+
+
+/*--------------------------------------------------------------------------*/
+/* Port decoding                                                            */
+/*--------------------------------------------------------------------------*/
+
+/*
+    Reads every port, with the frame count and with zero in B as the
+    MegaDrive decodes all 16 bits, and writes every eighth one. The
+    memory control register's I/O disable bit (bit 2) changes from frame
+    to frame, and from the sweep's own writes to it, so the port tables
+    are rebuilt with it set and clear; the SMS (J) FM detect port $F2 is
+    read both ways. Run with -fm and -console md to cover those consoles.
+*/
+static void build_port(char *dir, char *name)
+{
+    begin(0x8000);
+    common();
+
+    label(L_MAIN);
+    DB(0xCD); ref(L_SHOW);                  /* CALL show */
+    DB(0x3A); dw(IRQ_COUNT);                /* LD A,(count) */
+    DB(0x5F);                               /* LD E,A */
+
+    /* $F2 read with the I/O chip on and off */
+    DB(0x7B, 0xD3, 0xF2);                   /* LD A,E; OUT ($F2),A */
+    DB(0x7B, 0xE6, 0x01, 0x07, 0x07);       /* LD A,E; AND 1; RLCA; RLCA */
+    DB(0xF6, 0xAB, 0xD3, 0x3E);             /* OR $AB; OUT ($3E),A */
+    DB(0xDB, 0xF2, 0x32); dw(0xC200);       /* IN A,($F2); LD ($C200),A */
+    DB(0xEE, 0x04, 0xD3, 0x3E);             /* XOR 4; OUT ($3E),A */
+    DB(0xDB, 0xF2, 0x32); dw(0xC201);       /* IN A,($F2); LD ($C201),A */
+    DB(0x7B, 0xD3, 0x3F);                   /* LD A,E; OUT ($3F),A */
+
+    /* A note on the FM unit */
+    DB(0x3E, 0x30, 0xD3, 0xF0);             /* LD A,$30; OUT ($F0),A */
+    DB(0x3E, 0x10, 0xD3, 0xF1);             /* LD A,$10; OUT ($F1),A */
+    DB(0x3E, 0x10, 0xD3, 0xF0);             /* LD A,$10; OUT ($F0),A */
+    DB(0x7B, 0xD3, 0xF1);                   /* LD A,E; OUT ($F1),A */
+    DB(0x3E, 0x20, 0xD3, 0xF0);             /* LD A,$20; OUT ($F0),A */
+    DB(0x3E, 0x16, 0xD3, 0xF1);             /* LD A,$16; OUT ($F1),A */
+
+    DB(0x21); dw(RESULTS);                  /* LD HL,results */
+    DB(0x0E, 0x00);                         /* LD C,0 */
+    label(L_PORT);
+    DB(0x43, 0xED, 0x78, 0x77, 0x23);       /* LD B,E; IN A,(C); LD (HL),A; INC HL */
+    DB(0x06, 0x00, 0xED, 0x78, 0x77, 0x23); /* LD B,0; IN A,(C); LD (HL),A; INC HL */
+    DB(0x79, 0xE6, 0x07);                   /* LD A,C; AND 7 */
+    jr(0x20, L_PORT_SKIP);                  /* JR NZ,skip */
+    DB(0x7B, 0xED, 0x79);                   /* LD A,E; OUT (C),A */
+    label(L_PORT_SKIP);
+    DB(0x0C);                               /* INC C */
+    jr(0x20, L_PORT);                       /* JR NZ,port */
+
+    result_ptr = 0xC210;
+    result();
+    DB(0xC3); ref(L_MAIN);                  /* JP main */
+
+    save(dir, name);
+}
+
+
+/*--------------------------------------------------------------------------*/
+/* Bank switching                                                           */
+/*--------------------------------------------------------------------------*/
+
+/* Copy 32 bytes from an address to the next results */
+static void sample(int address)
+{
+    DB(0x21); dw(address);                  /* LD HL,nn */
+    DB(0x01); dw(0x0020);                   /* LD BC,$20 */
+    DB(0xED, 0xB0);                         /* LDIR */
+}
+
+
+/*
+    Sets the Sega mapper registers from the frame count, including bank
+    numbers past the end of the ROM and cartridge RAM in slot 2, and
+    writes the Codemasters registers at $0000, $4000 and $8000. What
+    each slot holds is shown at the start of the next frame, so that it
+    comes through a state load, and again after a final register write,
+    a word across $FFFD-$FFFE. Every byte of the ROM depends on its bank and
+    address, and the code stays in the first 1K, which both mappers
+    keep fixed. Run with -codies for the Codemasters mapper, and with
+    -state to restore the mapping from saved states.
+*/
+static void build_map(char *dir, char *name, int pages)
+{
+    int i;
+
+    begin(pages * 0x4000);
+    for(i = 0; i < rom_size; i++)
+        rom[i] = ((i >> 14) * 0x35 + (i >> 8) * 7 + i) & 0xFF;
+
+    common();
+
+    label(L_MAIN);
+    DB(0xCD); ref(L_SHOW);                  /* CALL show */
+    DB(0x3A); dw(IRQ_COUNT);                /* LD A,(count) */
+    DB(0x5F);                               /* LD E,A */
+
+    /* What the last pass mapped, across the frame (and any state load) */
+    DB(0x11); dw(RESULTS);                  /* LD DE,results */
+    sample(0x0400);
+    sample(0x3FE0);
+    sample(0x4000);
+    sample(0x7FE0);
+    sample(0x8000);
+    sample(0x87F0);
+    sample(0xBFE0);
+    sample(0xDF00);
+
+    /* Sega registers */
+    DB(0x7B, 0xE6, 0x1F);                   /* LD A,E; AND $1F */
+    DB(0x32); dw(0xFFFE);                   /* LD ($FFFE),A */
+    DB(0x7B, 0x0F, 0xE6, 0x1F);             /* LD A,E; RRCA; AND $1F */
+    DB(0x32); dw(0xFFFD);                   /* LD ($FFFD),A */
+    DB(0x7B, 0x0F, 0x0F, 0xE6, 0x0C);       /* LD A,E; RRCA; RRCA; AND $0C */
+    DB(0x32); dw(0xFFFC);                   /* LD ($FFFC),A */
+    DB(0x7B, 0x87, 0x83, 0xE6, 0x1F);       /* LD A,E; ADD A,A; ADD A,E; AND $1F */
+    DB(0x32); dw(0xFFFF);                   /* LD ($FFFF),A */
+
+    /* Codemasters registers, or writes to ROM */
+    DB(0x7B, 0xE6, 0x07);                   /* LD A,E; AND 7 */
+    DB(0x32); dw(0x8000);                   /* LD ($8000),A */
+    DB(0x7B, 0x0F);                         /* LD A,E; RRCA */
+    DB(0x32); dw(0x4000);                   /* LD ($4000),A */
+    DB(0x7B, 0x07);                         /* LD A,E; RLCA */
+    DB(0x32); dw(0x0000);                   /* LD ($0000),A */
+    DB(0x7B, 0x32); dw(0xFF00);             /* LD A,E; LD ($FF00),A */
+
+    /* Cartridge RAM, if it is mapped */
+    DB(0x7B, 0x32); dw(0x8800);             /* LD A,E; LD ($8800),A */
+    DB(0x32); dw(0xBFFF);                   /* LD ($BFFF),A */
+
+    /* A word write across two registers */
+    DB(0x7B, 0x6F);                         /* LD A,E; LD L,A */
+    DB(0xC6, 0x05, 0x67);                   /* ADD A,5; LD H,A */
+    DB(0x22); dw(0xFFFD);                   /* LD ($FFFD),HL */
+    DB(0x2A); dw(0xFFFC);                   /* LD HL,($FFFC) */
+    DB(0x22); dw(RESULTS + 0x100);          /* LD (nn),HL */
+    DB(0x2A); dw(0xFFFE);                   /* LD HL,($FFFE) */
+    DB(0x22); dw(RESULTS + 0x102);          /* LD (nn),HL */
+    DB(0x11); dw(RESULTS + 0x104);          /* LD DE,nn */
+    sample(0x0400);
+    sample(0x4000);
+
+    result_ptr = RESULTS + 0x150;
+    result();
+    DB(0xC3); ref(L_MAIN);                  /* JP main */
+
+    /* The rest of slot 0 is switched */
+    org(0x0400);
+
+    save(dir, name);
+}
+
+
+int main(int argc, char **argv)
+{
+    if(argc < 2)
+    {
+        printf("\n%s test ROM generator\n", APP_NAME);
+        printf("Version %s, build date: %s, %s\n", APP_VERSION, __DATE__, __TIME__);
+        printf("Usage: smstestrom <dir>\n");
+        exit(1);
+    }
+
+    build_block(argv[1], "blk1.sms", 1);
+    build_block(argv[1], "blk2.sms", 5);
+    build_block(argv[1], "blk1.gg", 1);
+    build_port(argv[1], "port.sms");
+    build_port(argv[1], "port.gg");
+    build_map(argv[1], "map3.sms", 3);
+    build_map(argv[1], "map4.sms", 4);
+    build_map(argv[1], "map16.sms", 16);
+
+    return 0;
+}
@@ -0,0 +1,316 @@
+/*
+    zex.c --
+    Z80 instruction exerciser harness.
+
+    Runs a CP/M program such as ZEXDOC or ZEXALL on the Z80 core alone,
+    with a flat 64K of RAM and just enough of the BDOS to print text.
+    Each line the program prints is treated as one instruction group;
+    groups ending in "OK" pass and groups reporting "ERROR" fail. The
+    emulated speed is reported per group and overall.
+*/
+
+#include "osd.h"
+#include <limits.h>
+
+/* CP/M memory layout */
+#define TPA_START       0x0100
+#define BDOS_ENTRY      0xFE00
+
+/* Ports used by the BDOS shim */
+#define PORT_BDOS       0x00
+#define PORT_BOOT       0x01
+
+#define MAX_GROUPS      0x100
+#define SLICE           100000
+
+typedef struct
+{
+    char name[0x100];
+    int ok;
+    double cycles;
+    double elapsed;
+} t_group;
+
+static uint8 ram[0x10000];
+static int done;
+
+static char line[0x100];
+static int line_len;
+static double line_cycles;
+static double line_start;
+
+static t_group group[MAX_GROUPS];
+static int group_count;
+
+static double cycles;
+static int quiet = 0;
+
+
+/* Cycles run so far, including the slice being executed */
+static double cycles_now(void)
+{
+    return cycles + SLICE - z80_ICount;
+}
+
+
+static void zex_writemem(int address, int data)
+{
+    ram[address & 0xFFFF] = data;
+}
+
+
+static uint8 zex_port_r(uint16 port)
+{
+    return 0xFF;
+}
+
+
+/* Finish the current output line, and record it if it ended a group */
+static void line_end(void)
+{
+    char *name = line;
+    char *p;
+    int ok;
+
+    line[line_len] = 0;
+    line_len = 0;
+
+    if(strstr(line, "ERROR"))
+        ok = 0;
+    else
+    if((p = strstr(line, "OK")) && p[2] == 0)
+        ok = 1;
+    else
+        return;
+
+    if(group_count == MAX_GROUPS)
+        return;
+
+    /* The group name is everything before the trailing dots */
+    while(*name == ' ')
+        name++;
+    snprintf(group[group_count].name, sizeof(group[0].name), "%s", name);
+    p = strstr(group[group_count].name, "..");
+    if(p)
+        *p = 0;
+
+    group[group_count].ok = ok;
+    group[group_count].cycles = cycles_now() - line_cycles;
+    group[group_count].elapsed = headless_time() - line_start;
+    group_count++;
+}
+
+
+static void console_out(int c)
+{
+    if(!quiet)
+    {
+        putchar(c);
+        if(c == '\n')
+            fflush(stdout);
+    }
+
+    if(c == '\r')
+        return;
+
+    if(c == '\n')
+    {
+        line_end();
+        return;
+    }
+
+    /* Time each group from the first character of its line */
+    if(line_len == 0)
+    {
+        line_cycles = cycles_now();
+        line_start = headless_time();
+    }
+
+    if(line_len < sizeof(line) - 1)
+        line[line_len++] = c;
+}
+
+
+/* BDOS calls are made with the function number in C */
+static void bdos(void)
+{
+    int c = z80_get_reg(Z80_BC) & 0xFF;
+    int de = z80_get_reg(Z80_DE);
+
+    switch(c)
+    {
+        case 2: /* C_WRITE */
+            console_out(de & 0xFF);
+            break;
+
+        case 9: /* C_WRITESTR */
+            while(ram[de] != '$')
+            {
+                console_out(ram[de]);
+                de = (de + 1) & 0xFFFF;
+            }
+            break;
+    }
+}
+
+
+static void zex_port_w(uint16 port, uint8 data)
+{
+    switch(port & 0xFF)
+    {
+        case PORT_BDOS:
+            bdos();
+            break;
+
+        case PORT_BOOT:
+            /* Warm boot: stop at the end of this instruction */
+            done = 1;
+            cycles -= z80_ICount;
+            z80_ICount = 0;
+            break;
+    }
+}
+
+
+static int load_com(char *filename)
+{
+    FILE *fd = fopen(filename, "rb");
+    if(!fd)
+        return 0;
+
+    memset(ram, 0, sizeof(ram));
+    fread(&ram[TPA_START], 1, BDOS_ENTRY - TPA_START, fd);
+    fclose(fd);
+
+    /* 0000: OUT (1),A - warm boot ends the run */
+    ram[0x0000] = 0xD3;
+    ram[0x0001] = PORT_BOOT;
+
+    /* 0005: JP BDOS_ENTRY, programs also read the top of the TPA from here */
+    ram[0x0005] = 0xC3;
+    ram[0x0006] = BDOS_ENTRY & 0xFF;
+    ram[0x0007] = BDOS_ENTRY >> 8;
+
+    /* BDOS_ENTRY: OUT (0),A; RET */
+    ram[BDOS_ENTRY + 0] = 0xD3;
+    ram[BDOS_ENTRY + 1] = PORT_BDOS;
+    ram[BDOS_ENTRY + 2] = 0xC9;
+
+    return 1;
+}
+
+
+static void report(double elapsed)
+{
+    int i, passed = 0;
+
+    printf("\n%-40s %-6s %14s %10s\n", "group", "result", "cycles", "MHz");
+
+    for(i = 0; i < group_count; i++)
+    {
+        t_group *g = &group[i];
+
+        printf("%-40.40s %-6s %14.0f %10.1f\n", g->name,
+            g->ok ? "ok" : "FAIL", g->cycles,
+            g->elapsed > 0.0 ? g->cycles / g->elapsed / 1e6 : 0.0);
+
+        passed += g->ok;
+    }
+
+    printf("\n");
+    printf("groups:      %d passed, %d failed\n", passed, group_count - passed);
+    printf("cycles:      %.0f\n", cycles);
+    printf("time:        %.3f s\n", elapsed);
+    printf("speed:       %.1f MHz\n", elapsed > 0.0 ? cycles / elapsed / 1e6 : 0.0);
+}
+
+
+int main(int argc, char **argv)
+{
+    double start, limit = 0.0;
+    int i, n;
+
+    /* Show usage if no arguments are specified */
+    if(argc < 2)
+    {
+        printf("\n%s Z80 exerciser harness\n", APP_NAME);
+        printf("Version %s, build date: %s, %s\n", APP_VERSION, __DATE__, __TIME__);
+        printf("Usage: smszex <file.com> [-options]\n");
+        printf("Options:\n");
+        printf(" -q           \t don't echo the program's output.\n");
+        printf(" -limit <n>   \t stop after n million cycles.\n");
+        printf(" -core <name> \t Z80 core: default, exact, fast or lean.\n");
+        exit(1);
+    }
+
+    for(i = 2; i < argc; i += n)
+    {
+        if(strcmp(argv[i], "-q") == 0)
+        {
+            quiet = 1;
+            n = 1;
+        }
+        else
+        if(strcmp(argv[i], "-limit") == 0 && i + 1 < argc)
+        {
+            limit = atof(argv[i + 1]) * 1e6;
+            n = 2;
+        }
+        else
+#ifdef Z80_CORES
+        if(strcmp(argv[i], "-core") == 0 && i + 1 < argc && z80_select_core(argv[i + 1]))
+        {
+            n = 2;
+        }
+        else
+#endif
+        {
+            printf("Unknown option `%s'.\n", argv[i]);
+            exit(1);
+        }
+    }
+
+    if(!load_com(argv[1]))
+    {
+        printf("Error loading `%s'.\n", argv[1]);
+        exit(1);
+    }
+
+    /* Flat 64K map, all of it writeable */
+    for(i = 0; i < 0x40; i++)
+    {
+        cpu_readmap[i] = &ram[i << 10];
+        cpu_writemap[i] = &ram[i << 10];
+    }
+    cpu_writemem16 = zex_writemem;
+    cpu_readport16 = zex_port_r;
+    cpu_writeport16 = zex_port_w;
+
+    z80_init();
+    z80_reset(NULL);
+    z80_set_reg(Z80_PC, TPA_START);
+    z80_set_reg(Z80_SP, BDOS_ENTRY);
+
+    start = headless_time();
+
+    while(!done)
+    {
+        cycles += z80_execute(SLICE);
+
+        if(limit > 0.0 && cycles >= limit)
+        {
+            printf("\nCycle limit reached.\n");
+            break;
+        }
+    }
+
+    report(headless_time() - start);
+
+    for(i = 0; i < group_count; i++)
+    {
+        if(!group[i].ok)
+            return 1;
+    }
+
+    return (done && group_count) ? 0 : 1;
+}
@@ -5,7 +5,7 @@
 
 #include "shared.h"
 
-char game_name[PATH_MAX];
+THREAD_LOCAL char game_name[PATH_MAX];
 
 typedef struct {
     uint32 crc;
@@ -5,7 +5,7 @@
 int load_rom(char *filename);
 unsigned char *loadzip(char *archive, char *filename, int *filesize);
 
-extern char game_name[1024];
+extern THREAD_LOCAL char game_name[PATH_MAX];
 
 #endif /* _LOADROM_H_ */
 
@@ -0,0 +1,281 @@
+/*
+    mapper.c --
+    Cartridge mappers.
+
+    A bank switch stores the new slot pointers and only derives the 1K
+    pages of a slot when they actually change, so games that rewrite
+    the same bank every few lines cost a compare. The pages have to be
+    current before the next instruction, as the Z80 core reads through
+    them without any check.
+*/
+#include "shared.h"
+
+/* Memory shown in each 16K slot */
+typedef struct
+{
+    uint8 *read;
+    uint8 *write;       /* NULL if writes are dropped */
+    int size;           /* 16K, or less for memory mirrored across the slot */
+} slot_t;
+
+/* Page flags */
+#define PAGE_FIXED      0x01    /* Keeps its cpu_readmap[] entry across bank switches */
+#define PAGE_TRAP       0x02    /* Writes go to the mapper */
+
+static THREAD_LOCAL const mapper_t *mapper;
+static THREAD_LOCAL slot_t slot[MAPPER_SLOTS];
+static THREAD_LOCAL uint8 page_flags[0x40];
+
+/* ROM address of each bank register value, to avoid a division per switch */
+static THREAD_LOCAL uint8 *bank_table[0x100];
+
+
+/*--------------------------------------------------------------------------*/
+/* Page table                                                               */
+/*--------------------------------------------------------------------------*/
+
+/* Show 'size' bytes at 'read' in a slot, mirrored to fill it */
+void mapper_map(int n, uint8 *read, uint8 *write, int size)
+{
+    slot_t *s = &slot[n];
+    int i;
+
+    /* Nothing to derive if the slot is unchanged */
+    if(s->read == read && s->write == write && s->size == size)
+        return;
+
+    s->read = read;
+    s->write = write;
+    s->size = size;
+
+    for(i = 0; i < 0x10; i++)
+    {
+        int page = (n << 4) | i;
+        int offset = (i << 10) & (size - 1);
+
+        if(!(page_flags[page] & PAGE_FIXED))
+            cpu_readmap[page] = read + offset;
+
+        cpu_writemap[page] = write ? write + offset : dummy_write;
+
+        if(page_flags[page] & PAGE_TRAP)
+            cpu_writeattr[page] = Z80_PAGE_HANDLER;
+        else
+            cpu_writeattr[page] = write ? Z80_PAGE_RAM : Z80_PAGE_ROM;
+    }
+
+    /* Code is fetched through a cached page pointer */
+    z80_remap();
+}
+
+
+/* Keep a page mapped to 'read' whatever its slot shows */
+void mapper_fix(int page, uint8 *read)
+{
+    page_flags[page] |= PAGE_FIXED;
+    cpu_readmap[page] = read;
+    z80_remap();
+}
+
+
+/* Send writes to a range of pages to the mapper */
+void mapper_trap(int first, int last)
+{
+    int i;
+
+    for(i = first; i <= last; i++)
+    {
+        page_flags[i] |= PAGE_TRAP;
+        cpu_writeattr[i] = Z80_PAGE_HANDLER;
+    }
+}
+
+
+/* ROM shown for a bank register value */
+uint8 *mapper_bank(int bank)
+{
+    return bank_table[bank & 0xFF];
+}
+
+
+/* Forget the slots and page flags, so the next mapping is done in full */
+static void mapper_clear(void)
+{
+    memset(slot, 0, sizeof(slot));
+    memset(page_flags, 0, sizeof(page_flags));
+}
+
+
+/*--------------------------------------------------------------------------*/
+/* Sega and Codemasters mappers                                             */
+/*--------------------------------------------------------------------------*/
+
+/* 0x8000-0xBFFF shows cartridge RAM when FCR bit 3 is set */
+static void sega_map_slot2(void)
+{
+    if(cart.fcr[0] & 8)
+    {
+        uint8 *sram = &cart.sram[(cart.fcr[0] & 4) ? 0x4000 : 0x0000];
+        sms.save = 1;
+        mapper_map(2, sram, sram, 0x4000);
+    }
+    else
+        mapper_map(2, mapper_bank(cart.fcr[3]), NULL, 0x4000);
+}
+
+
+static void sega_register_w(int address, int data)
+{
+    /* Save frame control register data */
+    cart.fcr[address] = data;
+
+    TRACE_EVENT(TRACE_BANK, (address << 8) | data);
+
+    switch(address)
+    {
+        case 0:
+        case 3:
+            sega_map_slot2();
+            break;
+
+        case 1:
+            mapper_map(0, mapper_bank(data), NULL, 0x4000);
+            break;
+
+        case 2:
+            mapper_map(1, mapper_bank(data), NULL, 0x4000);
+            break;
+    }
+}
+
+
+/* Map memory from the registers */
+static void sega_map(void)
+{
+    /* The first 1K always holds the start of the ROM */
+    mapper_fix(0x00, cart.rom);
+
+    mapper_map(0, mapper_bank(cart.fcr[1]), NULL, 0x4000);
+    mapper_map(1, mapper_bank(cart.fcr[2]), NULL, 0x4000);
+    sega_map_slot2();
+    mapper_map(3, sms.wram, sms.wram, 0x2000);
+}
+
+
+static void sega_defaults(void)
+{
+    cart.fcr[0] = 0x00;
+    cart.fcr[1] = 0x00;
+    cart.fcr[2] = 0x01;
+    cart.fcr[3] = 0x00;
+}
+
+
+/* Registers at 0xFFFC-0xFFFF, over the end of work RAM */
+static void sega_write(int offset, int data)
+{
+    cpu_writemap[offset >> 10][offset & 0x03FF] = data;
+    if(offset >= 0xFFFC)
+        sega_register_w(offset & 3, data);
+}
+
+
+static void sega_restore(void)
+{
+    mapper_trap(0x3F, 0x3F);
+    sega_map();
+}
+
+
+static void sega_reset(void)
+{
+    sega_defaults();
+    sega_restore();
+}
+
+
+/* A write anywhere in a ROM slot selects the bank shown in it */
+static void codies_write(int offset, int data)
+{
+    if(offset < 0xC000)
+        sega_register_w(1 + (offset >> 14), data);
+    else
+        cpu_writemap[offset >> 10][offset & 0x03FF] = data;
+}
+
+
+static void codies_restore(void)
+{
+    mapper_trap(0x00, 0x2F);
+    sega_map();
+}
+
+
+static void codies_reset(void)
+{
+    sega_defaults();
+    codies_restore();
+}
+
+
+/*--------------------------------------------------------------------------*/
+/* No mapper: 48K of ROM                                                    */
+/*--------------------------------------------------------------------------*/
+
+static void none_restore(void)
+{
+    mapper_map(0, mapper_bank(0), NULL, 0x4000);
+    mapper_map(1, mapper_bank(1), NULL, 0x4000);
+    mapper_map(2, mapper_bank(2), NULL, 0x4000);
+    mapper_map(3, sms.wram, sms.wram, 0x2000);
+}
+
+
+static void none_write(int offset, int data)
+{
+    cpu_writemap[offset >> 10][offset & 0x03FF] = data;
+}
+
+
+/* Indexed by cart.mapper */
+static const mapper_t mapper_list[] = {
+    { "none",           none_restore,   none_write,     none_restore    },
+    { "sega",           sega_reset,     sega_write,     sega_restore    },
+    { "codemasters",    codies_reset,   codies_write,   codies_restore  },
+};
+
+
+/*--------------------------------------------------------------------------*/
+/* Interface                                                                */
+/*--------------------------------------------------------------------------*/
+
+/* Select the mapper of the loaded game, before sms_reset() */
+void mapper_init(int type)
+{
+    int i;
+
+    if(type < 0 || type >= sizeof(mapper_list) / sizeof(mapper_t))
+        type = MAPPER_SEGA;
+    mapper = &mapper_list[type];
+
+    for(i = 0; i < 0x100; i++)
+        bank_table[i] = &cart.rom[(cart.pages ? i % cart.pages : 0) << 14];
+
+    cpu_writemem16 = mapper->write;
+}
+
+
+/* Map memory for power-on */
+void mapper_reset(void)
+{
+    mapper_clear();
+    mapper->reset();
+}
+
+
+/* Map memory again from the registers, after a state load */
+void mapper_restore(void)
+{
+    mapper_clear();
+    mapper->restore();
+}
@@ -0,0 +1,32 @@
+
+#ifndef _MAPPER_H_
+#define _MAPPER_H_
+
+/*
+    Cartridge mappers. Each one is a set of handlers that places memory
+    in the four 16K slots of the Z80 address space; the 1K pages the Z80
+    core reads through (cpu_readmap[], cpu_writemap[], cpu_writeattr[])
+    are derived from the slots by mapper_map(). The bank registers are
+    kept in cart.fcr[], which the save states already hold.
+*/
+
+#define MAPPER_SLOTS    4
+
+typedef struct
+{
+    const char *name;
+    void (*reset)(void);                    /* Set power-on registers and map them */
+    void (*write)(int offset, int data);    /* Writes to the pages given to mapper_trap() */
+    void (*restore)(void);                  /* Map memory from cart.fcr[] */
+} mapper_t;
+
+/* Function prototypes */
+void mapper_init(int type);
+void mapper_reset(void);
+void mapper_restore(void);
+void mapper_map(int slot, uint8 *read, uint8 *write, int size);
+void mapper_fix(int page, uint8 *read);
+void mapper_trap(int first, int last);
+uint8 *mapper_bank(int bank);
+
+#endif /* _MAPPER_H_ */
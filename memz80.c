@@ -5,8 +5,15 @@
 #include "shared.h"
 
 /* Pull-up resistors on data bus */
-uint8 data_bus_pullup   = 0x00;
-uint8 data_bus_pulldown = 0x00;
+THREAD_LOCAL uint8 data_bus_pullup   = 0x00;
+THREAD_LOCAL uint8 data_bus_pulldown = 0x00;
+
+/* Port handlers for the selected console, by the low byte of the port */
+typedef void (*port_w_t)(uint16 port, uint8 data);
+typedef uint8 (*port_r_t)(uint16 port);
+
+static THREAD_LOCAL port_w_t port_w_table[0x100];
+static THREAD_LOCAL port_r_t port_r_table[0x100];
 
 /* Read unmapped memory */
 uint8 z80_read_unmapped(void)
@@ -18,331 +25,314 @@ uint8 z80_read_unmapped(void)
     return ((data | data_bus_pullup) & ~data_bus_pulldown);
 }
 
-void memctrl_w(uint8 data)
-{
-    sms.memctrl = data;
-}
-
-/*--------------------------------------------------------------------------*/
-/* Sega Master System port handlers                                         */
-/*--------------------------------------------------------------------------*/
-
-void sms_port_w(uint16 port, uint8 data)
+/* Check if a port read has no side effects and gives the same value
+   for the rest of the time slice, used by the Z80 idle loop check.
+   Reading the V counter or the status flags ends the slice with the
+   current line (system_split()), so they hold still until then */
+int port_idle(uint16 port)
 {
     switch(port & 0xC1)
     {
-        case 0x00:
-            memctrl_w(data);
-            return;
-
-        case 0x01:
-            ioctrl_w(data);
-            return;
-
-        case 0x40:
-        case 0x41:
-            psg_write(data);
-            return;
-
-        case 0x80:
-        case 0x81:
-            vdp_write(port, data);
-            return;
-
-        case 0xC0:
-        case 0xC1:
-            return;
-    }
-}
-
-uint8 sms_port_r(uint16 port)
-{
-    switch(port & 0xC0)
-    {
-        case 0x00:
-            return z80_read_unmapped();
-
-        case 0x40:
-            return vdp_counter_r(port);
+        case 0x41: /* H counter */
+        case 0x80: /* VDP data port */
+            return 0;
 
-        case 0x80:
-            return vdp_read(port);
-
-        case 0xC0:
-            return input_r(port);
+        case 0x81: /* VDP status */
+            return !(vdp.status | vdp.pending | vdp.vint_pending | vdp.hint_pending);
     }
 
-    /* Just to please the compiler */
-    return -1;
+    return 1;
 }
 
-
-/*--------------------------------------------------------------------------*/
-/* Sega Master System (J) port handlers                                     */
-/*--------------------------------------------------------------------------*/
-
-void smsj_port_w(uint16 port, uint8 data)
+/* Write a run of bytes to the VDP data port or the PSG for OTIR and
+   OUTI. Other ports may change the memory map or the interrupt lines,
+   so their writes are left to go one at a time. A run sized past the
+   current line is turned down, system_split() ends the time slice with
+   the line and the Z80 sizes the run again */
+int port_write_block(uint16 port, const uint8 *src, int len)
 {
     port &= 0xFF;
 
-    if(port >= 0xF0)
-    {
-        switch(port)
-        {
-            case 0xF0:
-                fmunit_write(0, data);
-                return;
-
-            case 0xF1:
-                fmunit_write(1, data);
-                return;
-
-            case 0xF2:
-                fmunit_detect_w(data);
-                return;
-        }
-    }
+    if(sms.console == CONSOLE_GG && port <= 0x06)
+        return 0;
 
     switch(port & 0xC1)
     {
-        case 0x00:
-            memctrl_w(data);
-            return;
-
-        case 0x01:
-            ioctrl_w(data);
-            return;
-
         case 0x40:
         case 0x41:
-            psg_write(data);
-            return;
+            if(system_split())
+                return 0;
+            system_sync_audio();
+            psg_write_block(src, len);
+            return 1;
 
         case 0x80:
-        case 0x81:
-            vdp_write(port, data);
-            return;
-
-        case 0xC0:
-        case 0xC1:
-            return;
+            if(system_split())
+                return 0;
+            if(IS_GG)
+            {
+                while(len--)
+                    gg_vdp_write(port, *src++);
+            }
+            else
+            if(IS_MD)
+            {
+                while(len--)
+                    md_vdp_write(port, *src++);
+            }
+            else
+                vdp_write_block(src, len);
+            return 1;
     }
+
+    return 0;
 }
 
-uint8 smsj_port_r(uint16 port)
+/* Read a run of bytes from the VDP data port for INIR */
+int port_read_block(uint16 port, uint8 *dst, int len)
 {
     port &= 0xFF;
 
-    if(port == 0xF2 && !(sms.memctrl & 4))
-        return fmunit_detect_r();
+    if(sms.console == CONSOLE_GG && port <= 0x06)
+        return 0;
 
-    switch(port & 0xC0)
+    if((port & 0xC1) == 0x80)
     {
-        case 0x00:
-            return z80_read_unmapped();
-
-        case 0x40:
-            return vdp_counter_r(port);
-
-        case 0x80:
-            return vdp_read(port);
-
-        case 0xC0:
-            return input_r(port);
+        vdp_read_block(dst, len);
+        return 1;
     }
 
-    /* Just to please the compiler */
-    return -1;
+    return 0;
 }
 
+void memctrl_w(uint8 data)
+{
+    uint8 changed = sms.memctrl ^ data;
+
+    sms.memctrl = data;
 
+    /* Bit 2 disables the I/O chip */
+    if(changed & 0x04)
+        port_map();
+}
 
 /*--------------------------------------------------------------------------*/
-/* Game Gear port handlers                                                  */
+/* Port handlers                                                            */
 /*--------------------------------------------------------------------------*/
 
-void gg_port_w(uint16 port, uint8 data)
+static void none_w(uint16 port, uint8 data)
 {
-    port &= 0xFF;
+}
 
-    if(port <= 0x06) {
-        sio_w(port, data);
-        return;
-    }
+static void memctrl_port_w(uint16 port, uint8 data)
+{
+    memctrl_w(data);
+}
 
-    switch(port & 0xC1)
-    {
-        case 0x00:
-            memctrl_w(data);
-            return;
+static void ioctrl_port_w(uint16 port, uint8 data)
+{
+    ioctrl_w(data);
+}
 
-        case 0x01:
-            ioctrl_w(data);
-            return;
+static void psg_port_w(uint16 port, uint8 data)
+{
+    system_sync_audio();
+    psg_write(data);
+}
 
-        case 0x40:
-        case 0x41:
-            psg_write(data);
-            return;
+static void vdp_port_w(uint16 port, uint8 data)
+{
+    system_sync();
+    vdp_write(port, data);
+}
 
-        case 0x80:
-        case 0x81:
-            gg_vdp_write(port, data);
-            return;
-    }
+static void gg_vdp_port_w(uint16 port, uint8 data)
+{
+    system_sync();
+    gg_vdp_write(port, data);
 }
 
+static void md_vdp_port_w(uint16 port, uint8 data)
+{
+    system_sync();
+    md_vdp_write(port, data);
+}
 
-uint8 gg_port_r(uint16 port)
+static void sio_port_w(uint16 port, uint8 data)
 {
-    port &= 0xFF;
+    /* Port 6 is the PSG stereo control */
+    system_sync_audio();
+    sio_w(port & 0xFF, data);
+}
 
-    if(port <= 0x06)
-        return sio_r(port);
+static void fmunit_port_w(uint16 port, uint8 data)
+{
+    system_sync_audio();
+    fmunit_write(port & 1, data);
+}
 
-    switch(port & 0xC0)
-    {
-        case 0x00:
-            return z80_read_unmapped();
+static void fmunit_detect_port_w(uint16 port, uint8 data)
+{
+    fmunit_detect_w(data);
+}
 
-        case 0x40:
-            return vdp_counter_r(port);
+static uint8 unmapped_r(uint16 port)
+{
+    return z80_read_unmapped();
+}
 
-        case 0x80:
-            return vdp_read(port);
+static uint8 counter_port_r(uint16 port)
+{
+    system_split();
+    return vdp_counter_r(port);
+}
 
-        case 0xC0:
-            switch(port)
-            {
-                case 0xC0:
-                case 0xC1:
-                case 0xDC:
-                case 0xDD:
-                    return input_r(port);
-            }
-            return z80_read_unmapped();
-    }
+static uint8 vdp_port_r(uint16 port)
+{
+    /* Finishing lines sets the status flags */
+    if(port & 1)
+        system_split();
+    return vdp_read(port);
+}
 
-    /* Just to please the compiler */
-    return -1;
+static uint8 input_port_r(uint16 port)
+{
+    return input_r(port);
+}
+
+/* The MegaDrive decodes the controller ports on all 16 address bits */
+static uint8 md_input_port_r(uint16 port)
+{
+    if(port & 0xFF00)
+        return z80_read_unmapped();
+    return input_r(port);
+}
+
+static uint8 sio_port_r(uint16 port)
+{
+    return sio_r(port & 0xFF);
+}
+
+static uint8 fmunit_detect_port_r(uint16 port)
+{
+    return fmunit_detect_r();
 }
 
 /*--------------------------------------------------------------------------*/
-/* Game Gear (MS) port handlers                                             */
+/* Port decoding                                                            */
 /*--------------------------------------------------------------------------*/
 
-void ggms_port_w(uint16 port, uint8 data)
+/* Handler for writes to a port of the selected console */
+static port_w_t port_w_decode(int port)
 {
-    port &= 0xFF;
+    switch(sms.console)
+    {
+        case CONSOLE_SMSJ:
+            /* Mark III FM unit */
+            if(port == 0xF0 || port == 0xF1)
+                return fmunit_port_w;
+            if(port == 0xF2)
+                return fmunit_detect_port_w;
+            break;
+
+        case CONSOLE_GG:
+            /* Serial and stereo ports */
+            if(port <= 0x06)
+                return sio_port_w;
+            break;
+    }
 
     switch(port & 0xC1)
     {
         case 0x00:
-            memctrl_w(data);
-            return;
+            /* No memory control register on the MegaDrive */
+            return IS_MD ? none_w : memctrl_port_w;
 
         case 0x01:
-            ioctrl_w(data);
-            return;
+            return ioctrl_port_w;
 
         case 0x40:
         case 0x41:
-            psg_write(data);
-            return;
+            return psg_port_w;
 
         case 0x80:
         case 0x81:
-            gg_vdp_write(port, data);
-            return;
+            if(IS_GG)
+                return gg_vdp_port_w;
+            if(IS_MD)
+                return md_vdp_port_w;
+            return vdp_port_w;
     }
+
+    return none_w;
 }
 
-uint8 ggms_port_r(uint16 port)
+/* Handler for reads from a port of the selected console */
+static port_r_t port_r_decode(int port)
 {
-    port &= 0xFF;
+    switch(sms.console)
+    {
+        case CONSOLE_SMSJ:
+            if(port == 0xF2 && !(sms.memctrl & 4))
+                return fmunit_detect_port_r;
+            break;
+
+        case CONSOLE_GG:
+            if(port <= 0x06)
+                return sio_port_r;
+            break;
+    }
 
     switch(port & 0xC0)
     {
         case 0x00:
-            return z80_read_unmapped();
+            return unmapped_r;
 
         case 0x40:
-            return vdp_counter_r(port);
+            return counter_port_r;
 
         case 0x80:
-            return vdp_read(port);
+            return vdp_port_r;
 
         case 0xC0:
-            switch(port)
+            /* Only the controller ports are decoded on the GG and MD */
+            if(IS_GG || IS_MD)
             {
-                case 0xC0:
-                case 0xC1:
-                case 0xDC:
-                case 0xDD:
-                    return input_r(port);
+                switch(port)
+                {
+                    case 0xC0:
+                    case 0xC1:
+                    case 0xDC:
+                    case 0xDD:
+                        return IS_MD ? md_input_port_r : input_port_r;
+                }
+                return unmapped_r;
             }
-            return z80_read_unmapped();
+            return input_port_r;
     }
 
     /* Just to please the compiler */
-    return -1;
+    return unmapped_r;
 }
 
-/*--------------------------------------------------------------------------*/
-/* MegaDrive / Genesis port handlers                                        */
-/*--------------------------------------------------------------------------*/
-
-void md_port_w(uint16 port, uint8 data)
+/* Build the port handler tables for the selected console */
+void port_map(void)
 {
-    switch(port & 0xC1)
-    {
-        case 0x00:
-            /* No memory control register */
-            return;
-
-        case 0x01:
-            ioctrl_w(data);
-            return;
+    int port;
 
-        case 0x40:
-        case 0x41:
-            psg_write(data);
-            return;
-
-        case 0x80:
-        case 0x81:
-            md_vdp_write(port, data);
-            return;
+    for(port = 0; port < 0x100; port++)
+    {
+        port_w_table[port] = port_w_decode(port);
+        port_r_table[port] = port_r_decode(port);
     }
 }
 
-
-uint8 md_port_r(uint16 port)
+void port_w(uint16 port, uint8 data)
 {
-    switch(port & 0xC0)
-    {
-        case 0x00:
-            return z80_read_unmapped();
-
-        case 0x40:
-            return vdp_counter_r(port);
-
-        case 0x80:
-            return vdp_read(port);
-
-        case 0xC0:
-            switch(port)
-            {
-                case 0xC0:
-                case 0xC1:
-                case 0xDC:
-                case 0xDD:
-                    return input_r(port);
-            }
-            return z80_read_unmapped();
-    }
-
-    /* Just to please the compiler */
-    return -1;
+    port_w_table[port & 0xFF](port, data);
 }
 
+uint8 port_r(uint16 port)
+{
+    return port_r_table[port & 0xFF](port);
+}
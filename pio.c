@@ -5,14 +5,15 @@
 #include "shared.h"
 
 io_state io_lut[2][256];
-io_state *io_current;
+THREAD_LOCAL io_state *io_current;
 
 void pio_init(void)
 {
+    static int lut_ready = 0;
     int i, j;
 
-    /* Make pin state LUT */
-    for(j = 0; j < 2; j++)
+    /* Make pin state LUT, shared by every console in the process */
+    for(j = 0; j < 2 && !lut_ready; j++)
     {
         for(i = 0; i < 0x100; i++)
         {
@@ -40,6 +41,7 @@ void pio_init(void)
             }
         }
     }
+    lut_ready = 1;
 
     // hack dos code doesn't call system_reset
     pio_reset();
@@ -105,6 +107,8 @@ uint8 input_r(int offset)
     if(sms.memctrl & 0x04)
         return z80_read_unmapped();
 
+    lag.reads++;
+
     offset &= 1;
     if(offset == 0)
     {
@@ -185,6 +189,7 @@ uint8 sio_r(int offset)
     switch(offset & 0xFF)
     {
         case 0: /* Input port #2 */
+            lag.reads++;
             temp = 0xE0;
             if(input.system & INPUT_START)          temp &= ~0x80;
             if(sms.territory == TERRITORY_DOMESTIC) temp &= ~0x40;
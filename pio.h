@@ -40,7 +40,7 @@ typedef struct {
 
 /* Global variables */
 extern io_state io_lut[2][256];
-extern io_state *io_current;
+extern THREAD_LOCAL io_state *io_current;
 
 /* Function prototypes */
 void pio_init(void);
@@ -0,0 +1,506 @@
+/*
+    profile.c --
+    Guest code profiler.
+
+    Every executed instruction is counted against its location, which is
+    the physical ROM page mapped in by the cart.fcr registers plus the PC.
+    CALL, RST and interrupts open a frame on a shadow call stack and RET
+    closes it, so cycles can be reported per routine, inclusive of what
+    it calls, in callgrind format.
+*/
+#include "shared.h"
+
+#ifdef Z80_PROFILE
+
+/* Pseudo banks for code running outside the cartridge ROM */
+#define BANK_SRAM       0xFE
+#define BANK_RAM        0xFF
+
+/* Routine index for code run with an empty call stack */
+#define ROOT            0
+
+#define MAX_DEPTH       256
+#define MAX_FUNCS       (1 << 19)
+
+typedef unsigned long long u64;
+
+typedef struct
+{
+    u64 key;
+    u64 count;
+    u64 cycles;
+    u64 instr;
+} prof_entry_t;
+
+/* Open addressing hash table, keys are stored with bit 63 set */
+typedef struct
+{
+    prof_entry_t *entry;
+    uint32 size;
+    uint32 used;
+} prof_table_t;
+
+typedef struct
+{
+    uint32 func;
+    uint32 site;
+    uint32 sp;
+    u64 cycles;
+    u64 instr;
+} prof_frame_t;
+
+static THREAD_LOCAL prof_table_t insns;     /* (routine, location) */
+static THREAD_LOCAL prof_table_t edges;     /* (caller, callee, call site) */
+static THREAD_LOCAL prof_table_t funcs;     /* location -> routine */
+static THREAD_LOCAL uint32 *func_loc;
+static THREAD_LOCAL uint32 func_count;
+
+static THREAD_LOCAL prof_frame_t stack[MAX_DEPTH];
+static THREAD_LOCAL int depth;
+static THREAD_LOCAL int lost_frames;
+static THREAD_LOCAL uint32 insn_func;
+static THREAD_LOCAL uint32 last_loc;
+
+static THREAD_LOCAL u64 total_cycles;
+static THREAD_LOCAL u64 total_instr;
+
+
+static void table_free(prof_table_t *t)
+{
+    free(t->entry);
+    memset(t, 0, sizeof(prof_table_t));
+}
+
+
+static prof_entry_t *table_find(prof_table_t *t, u64 key)
+{
+    uint32 i;
+
+    key |= 1ULL << 63;
+
+    /* Keep the load factor under one half */
+    if(t->used * 2 >= t->size)
+    {
+        prof_table_t n;
+        uint32 j;
+
+        n.size = t->size ? t->size * 2 : 0x1000;
+        n.used = t->used;
+        n.entry = calloc(n.size, sizeof(prof_entry_t));
+        if(!n.entry)
+            return NULL;
+
+        for(j = 0; j < t->size; j++)
+        {
+            if(t->entry[j].key)
+            {
+                i = (uint32)((t->entry[j].key * 0x9E3779B97F4A7C15ULL) >> 40) & (n.size - 1);
+                while(n.entry[i].key)
+                    i = (i + 1) & (n.size - 1);
+                n.entry[i] = t->entry[j];
+            }
+        }
+
+        free(t->entry);
+        *t = n;
+    }
+
+    i = (uint32)((key * 0x9E3779B97F4A7C15ULL) >> 40) & (t->size - 1);
+    while(t->entry[i].key && t->entry[i].key != key)
+        i = (i + 1) & (t->size - 1);
+
+    if(!t->entry[i].key)
+    {
+        t->entry[i].key = key;
+        t->used++;
+    }
+
+    return &t->entry[i];
+}
+
+
+/* Bank and address of the code at 'pc' with the current mapping */
+static uint32 location(int pc)
+{
+    uint8 *p;
+    uint32 size = (cart.pages ? cart.pages : 256) * 0x4000;
+    int bank;
+
+    pc &= 0xFFFF;
+    p = cpu_readmap[pc >> 10];
+
+    if(p >= cart.rom && p < cart.rom + size)
+        bank = (p - cart.rom) >> 14;
+    else
+    if(p >= cart.sram && p < cart.sram + sizeof(cart.sram))
+        bank = BANK_SRAM;
+    else
+        bank = BANK_RAM;
+
+    return (bank << 16) | pc;
+}
+
+
+static uint32 func_index(uint32 loc)
+{
+    prof_entry_t *e = table_find(&funcs, loc);
+
+    if(!e)
+        return ROOT;
+
+    if(!e->count)
+    {
+        if(func_count == MAX_FUNCS)
+            return ROOT;
+
+        if((func_count & (func_count - 1)) == 0)
+        {
+            uint32 *p = realloc(func_loc, func_count * 2 * sizeof(uint32));
+            if(!p)
+                return ROOT;
+            func_loc = p;
+        }
+
+        func_loc[func_count] = loc;
+        e->count = func_count++;
+    }
+
+    return (uint32)e->count;
+}
+
+
+/* Close the top frame, charging its inclusive cost to the call edge */
+static void pop_frame(void)
+{
+    prof_frame_t *f = &stack[--depth];
+    uint32 caller = depth ? stack[depth - 1].func : ROOT;
+    prof_entry_t *e;
+
+    e = table_find(&edges, ((u64)caller << 43) | ((u64)f->func << 24) | f->site);
+    if(e)
+    {
+        e->count++;
+        e->cycles += total_cycles - f->cycles;
+        e->instr += total_instr - f->instr;
+    }
+}
+
+
+static void prof_insn(int pc, int cycles)
+{
+    uint32 loc = (pc < 0) ? last_loc : location(pc);
+    prof_entry_t *e = table_find(&insns, ((u64)insn_func << 24) | loc);
+
+    if(e)
+    {
+        e->count++;
+        e->cycles += cycles;
+    }
+
+    total_cycles += cycles;
+    total_instr++;
+    last_loc = loc;
+
+    /* Calls and returns made by this instruction take effect now */
+    insn_func = depth ? stack[depth - 1].func : ROOT;
+}
+
+
+static void prof_call(int pc, int target)
+{
+    prof_frame_t *f;
+
+    if(depth == MAX_DEPTH)
+    {
+        lost_frames++;
+        return;
+    }
+
+    f = &stack[depth++];
+    f->func = func_index(location(target));
+    f->site = (pc < 0) ? last_loc : location(pc);
+    f->sp = z80_get_reg(Z80_SP);
+    f->cycles = total_cycles;
+    f->instr = total_instr;
+
+    /* An interrupt taken between instructions starts the handler at once */
+    if(!z80_exec)
+        insn_func = f->func;
+}
+
+
+static void prof_ret(int sp)
+{
+    /* Also unwinds frames left behind by code that dropped its return address */
+    while(depth && stack[depth - 1].sp <= (uint32)sp)
+        pop_frame();
+}
+
+
+int profile_start(void)
+{
+    profile_stop();
+
+    table_free(&insns);
+    table_free(&edges);
+    table_free(&funcs);
+    free(func_loc);
+
+    func_loc = malloc(sizeof(uint32));
+    if(!func_loc)
+        return 0;
+    func_loc[ROOT] = 0xFFFFFFFF;
+    func_count = 1;
+
+    depth = lost_frames = 0;
+    insn_func = ROOT;
+    last_loc = 0;
+    total_cycles = total_instr = 0;
+    memset(z80_op_count, 0, sizeof(z80_op_count));
+
+    z80_profile_insn = prof_insn;
+    z80_profile_call = prof_call;
+    z80_profile_ret = prof_ret;
+    return 1;
+}
+
+
+void profile_stop(void)
+{
+    z80_profile_insn = NULL;
+    z80_profile_call = NULL;
+    z80_profile_ret = NULL;
+
+    while(depth)
+        pop_frame();
+}
+
+
+/*--------------------------------------------------------------------------*/
+/* Reports                                                                  */
+/*--------------------------------------------------------------------------*/
+
+/* Copy the used entries of a table out for sorting */
+static prof_entry_t *table_list(prof_table_t *t)
+{
+    prof_entry_t *list = malloc((t->used + 1) * sizeof(prof_entry_t));
+    uint32 i, n = 0;
+
+    if(!list)
+        return NULL;
+
+    for(i = 0; i < t->size; i++)
+    {
+        if(t->entry[i].key)
+        {
+            list[n] = t->entry[i];
+            list[n++].key &= ~(1ULL << 63);
+        }
+    }
+
+    return list;
+}
+
+
+static int compare_key(const void *a, const void *b)
+{
+    u64 x = ((const prof_entry_t *)a)->key, y = ((const prof_entry_t *)b)->key;
+    return (x > y) - (x < y);
+}
+
+
+static int compare_cycles(const void *a, const void *b)
+{
+    u64 x = ((const prof_entry_t *)a)->cycles, y = ((const prof_entry_t *)b)->cycles;
+    return (x < y) - (x > y);
+}
+
+
+static int compare_count(const void *a, const void *b)
+{
+    u64 x = ((const prof_entry_t *)a)->count, y = ((const prof_entry_t *)b)->count;
+    return (x < y) - (x > y);
+}
+
+
+static void write_func(FILE *fd, char *tag, uint32 func, uint8 *named)
+{
+    if(named[func])
+    {
+        fprintf(fd, "%s=(%u)\n", tag, func + 1);
+        return;
+    }
+
+    named[func] = 1;
+    if(func == ROOT)
+        fprintf(fd, "%s=(%u) (root)\n", tag, func + 1);
+    else
+        fprintf(fd, "%s=(%u) %02X:%04X\n", tag, func + 1,
+            func_loc[func] >> 16, func_loc[func] & 0xFFFF);
+}
+
+
+/*
+    Write a callgrind profile. Positions are the bank in the upper byte and
+    the Z80 address below it, costs are cycles and instructions.
+*/
+int profile_write_callgrind(char *filename, char *command)
+{
+    prof_entry_t *insn = table_list(&insns);
+    prof_entry_t *edge = table_list(&edges);
+    uint8 *named = calloc(func_count, 1);
+    uint32 i, j, func;
+    FILE *fd = fopen(filename, "w");
+
+    if(!fd || !insn || !edge || !named)
+    {
+        if(fd) fclose(fd);
+        free(insn);
+        free(edge);
+        free(named);
+        return 0;
+    }
+
+    /* Group by routine, then by location */
+    qsort(insn, insns.used, sizeof(prof_entry_t), compare_key);
+    qsort(edge, edges.used, sizeof(prof_entry_t), compare_key);
+
+    fprintf(fd, "# callgrind format\n");
+    fprintf(fd, "version: 1\n");
+    fprintf(fd, "creator: %s %s\n", APP_NAME, APP_VERSION);
+    fprintf(fd, "cmd: %s\n", command);
+    fprintf(fd, "positions: instr\n");
+    fprintf(fd, "events: Cycles Instructions\n");
+    fprintf(fd, "summary: %llu %llu\n\n", total_cycles, total_instr);
+    fprintf(fd, "ob=%s\n", command);
+
+    for(i = 0, j = 0; i < insns.used || j < edges.used;)
+    {
+        /* Next routine with self cost or outgoing calls */
+        uint32 fi = (i < insns.used) ? (uint32)(insn[i].key >> 24) : 0xFFFFFFFF;
+        uint32 fj = (j < edges.used) ? (uint32)(edge[j].key >> 43) : 0xFFFFFFFF;
+
+        func = (fi < fj) ? fi : fj;
+        fprintf(fd, "\n");
+        write_func(fd, "fn", func, named);
+
+        for(; i < insns.used && (uint32)(insn[i].key >> 24) == func; i++)
+        {
+            fprintf(fd, "0x%06X %llu %llu\n", (uint32)(insn[i].key & 0xFFFFFF),
+                insn[i].cycles, insn[i].count);
+        }
+
+        for(; j < edges.used && (uint32)(edge[j].key >> 43) == func; j++)
+        {
+            uint32 callee = (uint32)(edge[j].key >> 24) & (MAX_FUNCS - 1);
+
+            write_func(fd, "cfn", callee, named);
+            fprintf(fd, "calls=%llu 0x%06X\n", edge[j].count, func_loc[callee]);
+            fprintf(fd, "0x%06X %llu %llu\n", (uint32)(edge[j].key & 0xFFFFFF),
+                edge[j].cycles, edge[j].instr);
+        }
+    }
+
+    fclose(fd);
+    free(insn);
+    free(edge);
+    free(named);
+    return 1;
+}
+
+
+/* List the locations that took the most cycles */
+void profile_write_hot(FILE *fd, int count)
+{
+    prof_entry_t *insn = table_list(&insns);
+    uint32 i, n = 0;
+
+    if(!insn)
+        return;
+
+    /* Merge counts for a location reached from different routines */
+    for(i = 0; i < insns.used; i++)
+        insn[i].key &= 0xFFFFFF;
+    qsort(insn, insns.used, sizeof(prof_entry_t), compare_key);
+
+    for(i = 0; i < insns.used; i++)
+    {
+        if(n && insn[n - 1].key == insn[i].key)
+        {
+            insn[n - 1].count += insn[i].count;
+            insn[n - 1].cycles += insn[i].cycles;
+        }
+        else
+            insn[n++] = insn[i];
+    }
+
+    qsort(insn, n, sizeof(prof_entry_t), compare_cycles);
+
+    fprintf(fd, "bank:pc      cycles      %%  executions\n");
+    for(i = 0; i < n && i < (uint32)count; i++)
+    {
+        fprintf(fd, "%02X:%04X %12llu %5.1f %11llu\n",
+            (uint32)(insn[i].key >> 16), (uint32)(insn[i].key & 0xFFFF),
+            insn[i].cycles, total_cycles ? 100.0 * insn[i].cycles / total_cycles : 0.0,
+            insn[i].count);
+    }
+
+    if(lost_frames)
+        fprintf(fd, "(%d calls nested deeper than %d were not tracked)\n", lost_frames, MAX_DEPTH);
+
+    free(insn);
+}
+
+
+/* List the most frequently executed opcodes over all prefixes */
+void profile_write_opcodes(FILE *fd, int count)
+{
+    static const char *prefix[Z80_PROF_MAX] = { "", "CB ", "DD ", "ED ", "FD ", "xyCB " };
+    prof_entry_t list[Z80_PROF_MAX * 256];
+    u64 total = 0;
+    int i;
+
+    for(i = 0; i < Z80_PROF_MAX * 256; i++)
+    {
+        list[i].key = i;
+        list[i].count = z80_op_count[i >> 8][i & 0xFF];
+        total += list[i].count;
+    }
+
+    qsort(list, Z80_PROF_MAX * 256, sizeof(prof_entry_t), compare_count);
+
+    fprintf(fd, "opcode       executions      %%\n");
+    for(i = 0; i < count && i < Z80_PROF_MAX * 256 && list[i].count; i++)
+    {
+        char name[0x10];
+        sprintf(name, "%s%02X", prefix[list[i].key >> 8], (int)(list[i].key & 0xFF));
+        fprintf(fd, "%-10s %12llu %6.2f\n", name, list[i].count,
+            total ? 100.0 * list[i].count / total : 0.0);
+    }
+}
+
+#else
+
+int profile_start(void)
+{
+    return 0;
+}
+
+void profile_stop(void)
+{
+}
+
+int profile_write_callgrind(char *filename, char *command)
+{
+    return 0;
+}
+
+void profile_write_hot(FILE *fd, int count)
+{
+}
+
+void profile_write_opcodes(FILE *fd, int count)
+{
+}
+
+#endif /* Z80_PROFILE */
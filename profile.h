@@ -0,0 +1,17 @@
+
+#ifndef _PROFILE_H_
+#define _PROFILE_H_
+
+/*
+    Guest code profiler. Build with -DZ80_PROFILE to include the hooks in
+    the Z80 core; without it profile_start() fails and nothing is counted.
+*/
+
+/* Function prototypes */
+int profile_start(void);
+void profile_stop(void);
+int profile_write_callgrind(char *filename, char *command);
+void profile_write_hot(FILE *fd, int count);
+void profile_write_opcodes(FILE *fd, int count);
+
+#endif /* _PROFILE_H_ */
@@ -9,23 +9,23 @@ uint8 sms_cram_expand_table[4];
 uint8 gg_cram_expand_table[16];
 
 /* Background drawing function */
-void (*render_bg)(int line) = NULL;
-void (*render_obj)(int line) = NULL;
+THREAD_LOCAL void (*render_bg)(int line) = NULL;
+THREAD_LOCAL void (*render_obj)(int line) = NULL;
 
 /* Pointer to output buffer */
-uint8 *linebuf;
+THREAD_LOCAL uint8 *linebuf;
 
 /* Internal buffer for drawing non 8-bit displays */
-uint8 internal_buffer[0x100];
+THREAD_LOCAL uint8 internal_buffer[0x100];
 
 /* Precalculated pixel table */
-uint16 pixel[PALETTE_SIZE];
+THREAD_LOCAL uint16 pixel[PALETTE_SIZE];
 
 /* Dirty pattern info */
-uint8 bg_name_dirty[0x200];     /* 1= This pattern is dirty */
-uint16 bg_name_list[0x200];     /* List of modified pattern indices */
-uint16 bg_list_index;           /* # of modified patterns in list */
-uint8 bg_pattern_cache[0x20000];/* Cached and flipped patterns */
+THREAD_LOCAL uint8 bg_name_dirty[0x200];     /* 1= This pattern is dirty */
+THREAD_LOCAL uint16 bg_name_list[0x200];     /* List of modified pattern indices */
+THREAD_LOCAL uint16 bg_list_index;           /* # of modified patterns in list */
+THREAD_LOCAL uint8 bg_pattern_cache[0x20000];/* Cached and flipped patterns */
 
 /* Pixel look-up table */
 uint8 lut[0x10000];
@@ -100,8 +100,8 @@ void render_shutdown(void)
 {
 }
 
-/* Initialize the rendering data */
-void render_init(void)
+/* Build the look-up tables */
+static void make_render_tables(void)
 {
     int i, j;
     int bx, sx, b, s, bp, bf, sf, c;
@@ -205,9 +205,22 @@ void render_init(void)
         uint8 c = i << 4 | i;
         gg_cram_expand_table[i] = c;        
     }
+}
 
-    render_reset();
 
+/* Initialize the rendering data */
+void render_init(void)
+{
+    static int tables_ready = 0;
+
+    /* The tables never change, so every console in the process shares them */
+    if(!tables_ready)
+    {
+        make_render_tables();
+        tables_ready = 1;
+    }
+
+    render_reset();
 }
 
 
@@ -248,7 +261,9 @@ void render_line(int line)
     linebuf = (bitmap.depth == 8) ? &bitmap.data[(line * bitmap.pitch)] : &internal_buffer[0];
 
     /* Update pattern cache */
+    STATS_BEGIN(STATS_CACHE);
     update_bg_pattern_cache();
+    STATS_END(STATS_CACHE);
 
     /* Blank line (full width) */
     if(!(vdp.reg[1] & 0x40))
@@ -258,12 +273,16 @@ void render_line(int line)
     else
     {
         /* Draw background */
+        STATS_BEGIN(STATS_BG);
         if(render_bg != NULL)
             render_bg(line);
+        STATS_END(STATS_BG);
 
         /* Draw sprites */
+        STATS_BEGIN(STATS_OBJ);
         if(render_obj != NULL)
             render_obj(line);
+        STATS_END(STATS_OBJ);
 
         /* Blank leftmost column of display */
         if(vdp.reg[0] & 0x20)
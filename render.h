@@ -15,15 +15,15 @@
 
 extern uint8 sms_cram_expand_table[4];
 extern uint8 gg_cram_expand_table[16];
-extern void (*render_bg)(int line);
-extern void (*render_obj)(int line);
-extern uint8 *linebuf;
-extern uint8 internal_buffer[0x100];
-extern uint16 pixel[];
-extern uint8 bg_name_dirty[0x200];     
-extern uint16 bg_name_list[0x200];     
-extern uint16 bg_list_index;           
-extern uint8 bg_pattern_cache[0x20000];
+extern THREAD_LOCAL void (*render_bg)(int line);
+extern THREAD_LOCAL void (*render_obj)(int line);
+extern THREAD_LOCAL uint8 *linebuf;
+extern THREAD_LOCAL uint8 internal_buffer[0x100];
+extern THREAD_LOCAL uint16 pixel[];
+extern THREAD_LOCAL uint8 bg_name_dirty[0x200];     
+extern THREAD_LOCAL uint16 bg_name_list[0x200];     
+extern THREAD_LOCAL uint16 bg_list_index;           
+extern THREAD_LOCAL uint8 bg_pattern_cache[0x20000];
 extern uint8 tms_lookup[16][256][2];
 extern uint8 mc_lookup[16][256][8];
 extern uint8 txt_lookup[256][2];
@@ -23,6 +23,7 @@
 #include "macros.h"
 #include "z80.h"
 #include "sms.h"
+#include "mapper.h"
 #include "pio.h"
 #include "memz80.h"
 #include "vdp.h"
@@ -35,6 +36,11 @@
 #include "stream.h"
 #include "sound.h"
 #include "system.h"
+#include "instance.h"
+#include "stats.h"
+#include "trace.h"
+#include "profile.h"
+#include "hacks.h"
 #include "error.h"
 
 #include "state.h"
@@ -83,16 +83,15 @@ typedef struct
 } sms_t;
 
 /* Global data */
-extern sms_t sms;
+extern THREAD_LOCAL sms_t sms;
 
-extern uint8 dummy_write[0x400];
-extern uint8 dummy_read[0x400];
+extern THREAD_LOCAL uint8 dummy_write[0x400];
+extern THREAD_LOCAL uint8 dummy_read[0x400];
 
 /* Function prototypes */
 void sms_init(void);
 void sms_reset(void);
 void sms_shutdown(void);
-void sms_mapper_w(int address, int data);
 int sms_irq_callback(int param);
 
 #endif /* _SMS_H_ */
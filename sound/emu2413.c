@@ -154,9 +154,9 @@ static unsigned char default_inst[OPLL_TONE_NUM][(16+3)*16]=
 #define CAR(x) ch[x]->car
 
 /* Sampling rate */
-static uint32 rate ;
+static THREAD_LOCAL uint32 rate ;
 /* Input clock */
-static uint32 clk ;
+static THREAD_LOCAL uint32 clk ;
 
 /* WaveTable for each envelope amp */
 static uint32 fullsintable[PG_WIDTH] ;
@@ -179,8 +179,8 @@ static int32 pmtable[PM_PG_WIDTH] ;
 static int32 amtable[AM_PG_WIDTH] ;
 
 /* Noise and LFO */
-static uint32 pm_dphase ;
-static uint32 am_dphase ;
+static THREAD_LOCAL uint32 pm_dphase ;
+static THREAD_LOCAL uint32 am_dphase ;
 
 /* dB to Liner table */
 static int32 DB2LIN_TABLE[(DB_MUTE + DB_MUTE)*2] ;
@@ -199,16 +199,16 @@ static OPLL_PATCH default_patch[OPLL_TONE_NUM][(16+3)*2] ;
 enum { SETTLE,ATTACK,DECAY,SUSHOLD,SUSTINE,RELEASE,FINISH } ;
 
 /* Phase incr table for Attack */
-static uint32 dphaseARTable[16][16] ;
+static THREAD_LOCAL uint32 dphaseARTable[16][16] ;
 /* Phase incr table for Decay and Release */
-static uint32 dphaseDRTable[16][16] ;
+static THREAD_LOCAL uint32 dphaseDRTable[16][16] ;
 
 /* KSL + TL Table */
 static uint32 tllTable[16][8][1<<TL_BITS][4] ;
 static int32 rksTable[2][8][2] ;
 
-/* Phase incr table for PG */
-static uint32 dphaseTable[512][8][16] ; 
+/* Phase incr table for PG (depends on clock and rate, allocated per thread) */
+static THREAD_LOCAL uint32 (*dphaseTable)[8][16] ;
 
 /***************************************************
  
@@ -889,6 +889,8 @@ void OPLL_setClock(uint32 c, uint32 r)
 {
   clk = c ;
   rate = r ;
+  if(!dphaseTable)
+    dphaseTable = malloc(sizeof(uint32) * 512 * 8 * 16) ;
   makeDphaseTable() ;
   makeDphaseARTable() ;
   makeDphaseDRTable() ;
@@ -898,19 +900,28 @@ void OPLL_setClock(uint32 c, uint32 r)
 
 void OPLL_init(uint32 c, uint32 r)
 {
-  makePmTable() ;
-  makeAmTable() ;
-  makeDB2LinTable() ; 
-  makeAdjustTable() ;
-  makeTllTable() ;
-  makeRksTable() ;
-  makeSinTable() ;
-  makeDefaultPatch() ;
+  static int tables_ready = 0 ;
+
+  /* These tables are constant and shared by all threads */
+  if(!tables_ready)
+  {
+    makePmTable() ;
+    makeAmTable() ;
+    makeDB2LinTable() ; 
+    makeAdjustTable() ;
+    makeTllTable() ;
+    makeRksTable() ;
+    makeSinTable() ;
+    makeDefaultPatch() ;
+    tables_ready = 1 ;
+  }
   OPLL_setClock(c,r) ;
 }
 
 void OPLL_close(void)
 {
+  free(dphaseTable) ;
+  dphaseTable = NULL ;
 }
 
 /*********************************************************
@@ -1552,7 +1563,7 @@ void OPLL_writeIO(OPLL *opll, uint32 adr, uint32 val)
 
 void OPLL_write(OPLL *opll, int offset, int data)
 {
-    static uint8 latch = 0;
+    static THREAD_LOCAL uint8 latch = 0;
 
     if(offset & 1)
         OPLL_writeReg(opll, latch, data);
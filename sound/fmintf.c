@@ -4,8 +4,8 @@
 */
 #include "shared.h"
 
-static OPLL *opll;
-FM_Context fm_context;
+static THREAD_LOCAL OPLL *opll;
+THREAD_LOCAL FM_Context fm_context;
 
 void FM_Init(void)
 {
@@ -4,11 +4,11 @@
 */
 #include "shared.h"
 
-snd_t snd;
-static int16 **fm_buffer;
-static int16 **psg_buffer;
-int *smptab;
-int smptab_len;
+THREAD_LOCAL snd_t snd;
+static THREAD_LOCAL int16 **fm_buffer;
+static THREAD_LOCAL int16 **psg_buffer;
+THREAD_LOCAL int *smptab;
+THREAD_LOCAL int smptab_len;
 
 int sound_init(void)
 {
@@ -171,13 +171,19 @@ void sound_update(int line)
     	fm[1]  = fm_buffer[1] + snd.done_so_far;
 
 	    /* Generate SN76489 sample data */
+	    STATS_BEGIN(STATS_PSG);
 	    SN76489_Update(0, psg, snd.sample_count - snd.done_so_far);
+	    STATS_END(STATS_PSG);
 
 	    /* Generate YM2413 sample data */
+	    STATS_BEGIN(STATS_FM);
 	    FM_Update(fm, snd.sample_count - snd.done_so_far);
+	    STATS_END(STATS_FM);
 
 	    /* Mix streams into output buffer */
+	    STATS_BEGIN(STATS_MIX);
     	snd.mixer_callback(snd.stream, snd.output, snd.sample_count);
+	    STATS_END(STATS_MIX);
     	
     	/* Reset */
     	snd.done_so_far = 0;
@@ -195,10 +201,14 @@ void sound_update(int line)
     	fm[1]  = fm_buffer[1] + snd.done_so_far;
 
 	    /* Generate SN76489 sample data */
+	    STATS_BEGIN(STATS_PSG);
 	    SN76489_Update(0, psg, tinybit);
+	    STATS_END(STATS_PSG);
 
 	    /* Generate YM2413 sample data */
+	    STATS_BEGIN(STATS_FM);
 	    FM_Update(fm, tinybit);
+	    STATS_END(STATS_FM);
 
 		/* Sum total */
     	snd.done_so_far += tinybit;
@@ -241,6 +251,14 @@ void psg_write(int data)
     SN76489_Write(0, data);
 }
 
+void psg_write_block(const uint8 *src, int len)
+{
+    if(!snd.enabled)
+        return;
+    while(len--)
+        SN76489_Write(0, *src++);
+}
+
 /*--------------------------------------------------------------------------*/
 /* Mark III FM Unit / Master System (J) built-in FM handlers                */
 /*--------------------------------------------------------------------------*/
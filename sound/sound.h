@@ -29,10 +29,11 @@ typedef struct
 
 
 /* Global data */
-extern snd_t snd;
+extern THREAD_LOCAL snd_t snd;
 
 /* Function prototypes */
 void psg_write(int data);
+void psg_write_block(const uint8 *src, int len);
 void psg_stereo_w(int data);
 int fmunit_detect_r(void);
 void fmunit_detect_w(int data);
@@ -440,13 +440,13 @@ static const UINT8 mul_tab[16]= {
 *	TL_RES_LEN - sinus resolution (X axis)
 */
 #define TL_TAB_LEN (11*2*TL_RES_LEN)
-static signed int tl_tab[TL_TAB_LEN];
+static THREAD_LOCAL signed int tl_tab[TL_TAB_LEN];
 
 #define ENV_QUIET		(TL_TAB_LEN>>5)
 
 /* sin waveform table in 'decibel' scale */
 /* two waveforms on OPLL type chips */
-static unsigned int sin_tab[SIN_LEN * 2];
+static THREAD_LOCAL unsigned int sin_tab[SIN_LEN * 2];
 
 
 /* LFO Amplitude Modulation table (verified on real YM3812)
@@ -600,17 +600,17 @@ static unsigned char table[19][8] = {
 };
 
 /* lock level of common table */
-static int num_lock = 0;
+static THREAD_LOCAL int num_lock = 0;
 
 /* work table */
-static void *cur_chip = NULL;	/* current chip pointer */
-static YM2413_OPLL_SLOT *SLOT7_1,*SLOT7_2,*SLOT8_1,*SLOT8_2;
+static THREAD_LOCAL void *cur_chip = NULL;	/* current chip pointer */
+static THREAD_LOCAL YM2413_OPLL_SLOT *SLOT7_1,*SLOT7_2,*SLOT8_1,*SLOT8_2;
 
-static signed int output[2];
-static signed int outchan;
+static THREAD_LOCAL signed int output[2];
+static THREAD_LOCAL signed int outchan;
 
-static UINT32	LFO_AM;
-static INT32	LFO_PM;
+static THREAD_LOCAL UINT32	LFO_AM;
+static THREAD_LOCAL INT32	LFO_PM;
 
 
 MAME_INLINE int limit( int val, int max, int min ) {
@@ -2013,8 +2013,8 @@ static unsigned char OPLLRead(YM2413 *chip,int a)
 #define MAX_OPLL_CHIPS 4
 
 
-static YM2413 *OPLL_YM2413[MAX_OPLL_CHIPS];	/* array of pointers to the YM2413's */
-static int YM2413NumChips = 0;				/* number of chips */
+static THREAD_LOCAL YM2413 *OPLL_YM2413[MAX_OPLL_CHIPS];	/* array of pointers to the YM2413's */
+static THREAD_LOCAL int YM2413NumChips = 0;				/* number of chips */
 
 int YM2413Init(int num, int clock, int rate)
 {
@@ -137,23 +137,9 @@ int load_state_from_mem(void *stor)
 
     /* Restore callbacks */
     z80_set_irq_callback(sms_irq_callback);
+    port_map();
 
-    for(i = 0x00; i <= 0x2F; i++)
-    {
-        cpu_readmap[i]  = &cart.rom[(i & 0x1F) << 10];
-        cpu_writemap[i] = dummy_write;
-    }
-
-    for(i = 0x30; i <= 0x3F; i++)
-    {
-        cpu_readmap[i] = &sms.wram[(i & 0x07) << 10];
-        cpu_writemap[i] = &sms.wram[(i & 0x07) << 10];
-    }
-
-    sms_mapper_w(3, cart.fcr[3]);
-    sms_mapper_w(2, cart.fcr[2]);
-    sms_mapper_w(1, cart.fcr[1]);
-    sms_mapper_w(0, cart.fcr[0]);
+    mapper_restore();
 
     /* Force full pattern cache update */
     bg_list_index = 0x200;
@@ -253,23 +239,9 @@ void system_load_state(void *fd)
 
     /* Restore callbacks */
     z80_set_irq_callback(sms_irq_callback);
+    port_map();
 
-    for(i = 0x00; i <= 0x2F; i++)
-    {
-        cpu_readmap[i]  = &cart.rom[(i & 0x1F) << 10];
-        cpu_writemap[i] = dummy_write;
-    }
-
-    for(i = 0x30; i <= 0x3F; i++)
-    {
-        cpu_readmap[i] = &sms.wram[(i & 0x07) << 10];
-        cpu_writemap[i] = &sms.wram[(i & 0x07) << 10];
-    }
-
-    sms_mapper_w(3, cart.fcr[3]);
-    sms_mapper_w(2, cart.fcr[2]);
-    sms_mapper_w(1, cart.fcr[1]);
-    sms_mapper_w(0, cart.fcr[0]);
+    mapper_restore();
 
     /* Force full pattern cache update */
     bg_list_index = 0x200;
@@ -0,0 +1,181 @@
+/*
+    stats.c --
+    Per-subsystem cost counters.
+*/
+#include "shared.h"
+
+#ifdef LINUX
+#include <time.h>
+#endif
+
+/* Length of one counter tick */
+static double ns_per_tick = 0.0;
+
+
+/* Wall clock in seconds, used to calibrate the counter */
+static double stats_wall(void)
+{
+#ifdef LINUX
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#else
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+
+#if !(defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)))
+stats_tick_t stats_clock(void)
+{
+    return (stats_tick_t)(stats_wall() * 1e9);
+}
+#endif
+
+
+/* Return the length of one stats_clock() tick in nanoseconds */
+double stats_tick_ns(void)
+{
+    double start, end;
+    stats_tick_t ticks;
+
+    if(ns_per_tick != 0.0)
+        return ns_per_tick;
+
+    start = stats_wall();
+    ticks = stats_clock();
+
+    /* Calibrate by spinning for 10ms against the wall clock */
+    do {
+        end = stats_wall();
+    } while(end - start < 0.01);
+
+    ticks = stats_clock() - ticks;
+    ns_per_tick = ticks ? (end - start) * 1e9 / ticks : 1.0;
+    return ns_per_tick;
+}
+
+
+#ifdef STATS
+
+THREAD_LOCAL stats_tick_t stats_start[STATS_MAX];
+THREAD_LOCAL stats_tick_t stats_ticks[STATS_MAX];
+THREAD_LOCAL uint32 stats_calls[STATS_MAX];
+
+/* Completed frames, oldest first once the ring has wrapped */
+static THREAD_LOCAL stats_frame_t history[STATS_HISTORY];
+static THREAD_LOCAL int history_pos;
+static THREAD_LOCAL int history_count;
+
+
+void stats_reset(void)
+{
+    stats_tick_ns();
+
+    memset(stats_ticks, 0, sizeof(stats_ticks));
+    memset(stats_calls, 0, sizeof(stats_calls));
+    history_pos = history_count = 0;
+}
+
+
+/* Close the current frame and move its counters into the history */
+void stats_frame_end(void)
+{
+    stats_frame_t *f = &history[history_pos];
+    int i;
+
+    for(i = 0; i < STATS_MAX; i++)
+    {
+        f->ns[i] = stats_ticks[i] * stats_tick_ns();
+        f->calls[i] = stats_calls[i];
+        stats_ticks[i] = 0;
+        stats_calls[i] = 0;
+    }
+
+    history_pos = (history_pos + 1) % STATS_HISTORY;
+    if(history_count < STATS_HISTORY)
+        history_count++;
+}
+
+
+/* Return the counters of the last complete frame */
+int stats_get(stats_frame_t *frame)
+{
+    if(!history_count)
+        return 0;
+
+    *frame = history[(history_pos + STATS_HISTORY - 1) % STATS_HISTORY];
+    return 1;
+}
+
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+
+/* Return percentiles of each phase over the frames in the history */
+int stats_summary(stats_summary_t *summary)
+{
+    double sorted[STATS_HISTORY];
+    int i, j, n = history_count;
+
+    memset(summary, 0, sizeof(stats_summary_t));
+    if(!n)
+        return 0;
+
+    summary->frames = n;
+
+    for(i = 0; i < STATS_MAX; i++)
+    {
+        for(j = 0; j < n; j++)
+            sorted[j] = history[j].ns[i];
+
+        qsort(sorted, n, sizeof(double), compare_double);
+
+        summary->p50[i] = sorted[(n - 1) * 50 / 100];
+        summary->p90[i] = sorted[(n - 1) * 90 / 100];
+        summary->p99[i] = sorted[(n - 1) * 99 / 100];
+        summary->max[i] = sorted[n - 1];
+    }
+
+    return 1;
+}
+
+#else
+
+void stats_reset(void)
+{
+}
+
+void stats_frame_end(void)
+{
+}
+
+int stats_get(stats_frame_t *frame)
+{
+    return 0;
+}
+
+int stats_summary(stats_summary_t *summary)
+{
+    memset(summary, 0, sizeof(stats_summary_t));
+    return 0;
+}
+
+#endif /* STATS */
+
+
+const char *stats_name(int phase)
+{
+    static const char *name[STATS_MAX] = {
+        "z80", "bg", "sprite", "cache", "psg", "fm", "mix", "frame"
+    };
+
+    if(phase < 0 || phase >= STATS_MAX)
+        return "";
+
+    return name[phase];
+}
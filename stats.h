@@ -0,0 +1,81 @@
+
+#ifndef _STATS_H_
+#define _STATS_H_
+
+/*
+    Per-subsystem cost counters. Build with -DSTATS to enable them; without
+    it the STATS_* macros expand to nothing and the query functions return
+    zero, so the counters cost nothing in a normal build.
+*/
+
+/* Phases of the frame that are timed */
+enum {
+    STATS_Z80 = 0,          /* Z80 execution, including memory and port handlers */
+    STATS_BG,               /* Background rendering */
+    STATS_OBJ,              /* Sprite rendering and sprite parsing */
+    STATS_CACHE,            /* Background pattern cache updates */
+    STATS_PSG,              /* SN76489 synthesis */
+    STATS_FM,               /* YM2413 synthesis */
+    STATS_MIX,              /* Mixing into the output buffers */
+    STATS_FRAME,            /* The whole of system_frame() */
+    STATS_MAX
+};
+
+/* Number of frames kept for the rolling percentiles */
+#define STATS_HISTORY       256
+
+/* Cost of one frame */
+typedef struct
+{
+    double ns[STATS_MAX];   /* Time spent in each phase */
+    uint32 calls[STATS_MAX];/* Times each phase was entered */
+} stats_frame_t;
+
+/* Rolling percentiles of the time per frame, in nanoseconds */
+typedef struct
+{
+    int frames;             /* Frames the figures are taken over */
+    double p50[STATS_MAX];
+    double p90[STATS_MAX];
+    double p99[STATS_MAX];
+    double max[STATS_MAX];
+} stats_summary_t;
+
+typedef unsigned long long stats_tick_t;
+
+/* Fast counter, see stats_tick_ns() for its rate */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define stats_clock()       ((stats_tick_t)__builtin_ia32_rdtsc())
+#else
+stats_tick_t stats_clock(void);
+#endif
+
+#ifdef STATS
+
+extern THREAD_LOCAL stats_tick_t stats_start[STATS_MAX];
+extern THREAD_LOCAL stats_tick_t stats_ticks[STATS_MAX];
+extern THREAD_LOCAL uint32 stats_calls[STATS_MAX];
+
+#define STATS_BEGIN(p)      stats_start[p] = stats_clock()
+#define STATS_END(p)        do { stats_ticks[p] += stats_clock() - stats_start[p]; stats_calls[p]++; } while(0)
+#define STATS_RESET()       stats_reset()
+#define STATS_FRAME_END()   stats_frame_end()
+
+#else
+
+#define STATS_BEGIN(p)
+#define STATS_END(p)
+#define STATS_RESET()
+#define STATS_FRAME_END()
+
+#endif /* STATS */
+
+/* Function prototypes */
+void stats_reset(void);
+void stats_frame_end(void);
+int stats_get(stats_frame_t *frame);
+int stats_summary(stats_summary_t *summary);
+const char *stats_name(int phase);
+double stats_tick_ns(void);
+
+#endif /* _STATS_H_ */
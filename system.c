@@ -18,16 +18,218 @@
 
 #include "shared.h"
 
-bitmap_t bitmap;
-cart_t cart;                
-input_t input;
+THREAD_LOCAL bitmap_t bitmap;
+THREAD_LOCAL cart_t cart;                
+THREAD_LOCAL input_t input;
+THREAD_LOCAL lag_t lag;
+
+/* Cycles from the end of a line to the interrupt it raises */
+#define IRQ_DELAY           16
+
+/*
+    Scanline scheduler. The Z80 runs straight to the next event: a line or
+    frame interrupt that is enabled, or the end of the frame. The work due
+    at the end of each line (rendering, sprite parsing, the line counter
+    and the VDP flags) is caught up by system_sync() when the Z80 writes
+    the VDP or reads its flags or counters, and at each event. Sound is
+    generated up to the last finished line when the PSG or FM unit is
+    written, and at the end of the frame. Times are in cycles from the
+    start of the frame.
+
+    An overclock inserts hidden lines when the frame interrupt is raised.
+    The Z80 runs through them while the frame's clock stands still, so the
+    VDP, the counters and the sound see a frame of the usual length.
+*/
+typedef struct
+{
+    uint32 base;            /* z80_get_elapsed_cycles() at cycle 0 */
+    int lines;              /* Lines in this frame */
+    int end;                /* Cycle the running time slice ends at */
+    int hint;               /* Cycle a flagged line interrupt is raised at, or -1 */
+    int vint;               /* Cycle a flagged frame interrupt is raised at, or -1 */
+    int audio;              /* Last line sound has been generated for */
+    int carry;              /* Cycles the last frame ran past its end */
+    int hidden;             /* Cycles of hidden lines added to each frame */
+    int stall;              /* Cycle the hidden lines are inserted at, or -1 */
+    int skip_render;
+} sched_t;
+
+static const int iline_table[] = {0xC0, 0xE0, 0xF0};
+static THREAD_LOCAL sched_t sched;
+
+static int sched_now(void)
+{
+    return (int)((uint32)z80_get_elapsed_cycles() - sched.base);
+}
+
+/* Finish line 'vdp.line', as it stands after the Z80 has run through it */
+static void line_end(void)
+{
+    int line = vdp.line;
+    int iline = iline_table[vdp.extended];
+    int irq = (line + 1) * CYCLES_PER_LINE + IRQ_DELAY;
+
+    TRACE_BEGIN(TRACE_LINE);
+
+    if(!sched.skip_render)
+    {
+        TRACE_BEGIN(TRACE_RENDER);
+        render_line(line);
+        TRACE_END(TRACE_RENDER, line);
+    }
+
+    if(line <= iline)
+    {
+        vdp.left -= 1;
+        if(vdp.left == -1)
+        {
+            vdp.left = vdp.reg[0x0A];
+            vdp.hint_pending = 1;
+            sched.hint = irq;
+        }
+    }
+    else
+    {
+        vdp.left = vdp.reg[0x0A];
+    }
+
+    if(line == iline)
+    {
+        vdp.status |= 0x80;
+        vdp.vint_pending = 1;
+        sched.vint = irq;
+        if(sched.hidden)
+            sched.stall = irq;
+    }
+
+    TRACE_END(TRACE_LINE, line);
+
+    ++vdp.line;
+
+    if(vdp.mode <= 7)
+    {
+        STATS_BEGIN(STATS_OBJ);
+        parse_line(vdp.line);
+        STATS_END(STATS_OBJ);
+    }
+}
+
+/* Cycle of the next event, the earliest the Z80 has to stop at */
+static int next_event(void)
+{
+    int iline = iline_table[vdp.extended];
+    int end = sched.lines * CYCLES_PER_LINE;
+    int time;
+
+    if(sched.hint >= 0 && sched.hint < end)
+        end = sched.hint;
+
+    if(sched.vint >= 0 && sched.vint < end)
+        end = sched.vint;
+
+    if(sched.stall >= 0 && sched.stall < end)
+        end = sched.stall;
+
+    if(vdp.line <= iline)
+    {
+        /* The line counter underflows 'left' lines from now */
+        time = (vdp.line + vdp.left + 1) * CYCLES_PER_LINE + IRQ_DELAY;
+        if((vdp.reg[0x00] & 0x10) && vdp.line + vdp.left <= iline && time < end)
+            end = time;
+
+        time = (iline + 1) * CYCLES_PER_LINE + IRQ_DELAY;
+        if(((vdp.reg[0x01] & 0x20) || sched.hidden) && time < end)
+            end = time;
+    }
+
+    return end;
+}
+
+/* Finish the lines the Z80 has run through */
+void system_sync(void)
+{
+    int now = sched_now();
+#ifdef STATS
+    stats_tick_t start = stats_clock();
+#endif
+
+    while(vdp.line < sched.lines && now >= (vdp.line + 1) * CYCLES_PER_LINE)
+        line_end();
+
+#ifdef STATS
+    /* Lines caught up from a port handler don't count as Z80 time */
+    stats_start[STATS_Z80] += stats_clock() - start;
+#endif
+}
+
+/*
+    As system_sync(), and end the running time slice with the current line.
+    For reads of the VDP flags and counters, which the Z80 idle loop check
+    takes to hold still for the rest of the slice, and for runs of writes
+    done at once by the block I/O shortcuts. Returns non-zero if the slice
+    was cut short.
+*/
+int system_split(void)
+{
+    int end;
+
+    system_sync();
+
+    end = (vdp.line + 1) * CYCLES_PER_LINE;
+    if(end < sched.end)
+    {
+        z80_end_slice(end - sched_now());
+        sched.end = end;
+        return 1;
+    }
+
+    return 0;
+}
+
+/* As system_sync(), and also generate sound up to the current line */
+void system_sync_audio(void)
+{
+    int line;
+
+    system_sync();
+
+    /* The last line of the frame finishes the buffers in system_frame() */
+    line = vdp.line - 1;
+    if(line > sched.audio && line < sched.lines - 1)
+    {
+        TRACE_BEGIN(TRACE_AUDIO);
+        sound_update(line);
+        TRACE_END(TRACE_AUDIO, line);
+        sched.audio = line;
+    }
+}
+
+/* An interrupt enable or the display height changed, end the running
+   time slice early if the next event is now sooner */
+void system_reschedule(void)
+{
+    int end = next_event();
+
+    if(end < sched.end)
+    {
+        z80_end_slice(end - sched_now());
+        sched.end = end;
+    }
+}
+
+/* Cycles into the current line, for the H counter */
+int system_line_cycles(void)
+{
+    int cycles = sched_now() - vdp.line * CYCLES_PER_LINE;
+    return (cycles < 0) ? 0 : cycles;
+}
 
 /* Run the virtual console emulation for one frame */
 void system_frame(int skip_render)
 {
-    static int iline_table[] = {0xC0, 0xE0, 0xF0};
     int lpf = (sms.display == DISPLAY_NTSC) ? 262 : 313;
-    int iline;
+    int end = lpf * CYCLES_PER_LINE;
+    int now;
 
     /* Debounce pause key */
     if(input.system & INPUT_PAUSE)
@@ -45,64 +247,86 @@ void system_frame(int skip_render)
          sms.paused = 0;
     }
 
+    STATS_BEGIN(STATS_FRAME);
+    TRACE_BEGIN(TRACE_FRAME);
+
     text_counter = 0;
+    lag.reads = 0;
 
     /* End of frame, parse sprites for line 0 on line 261 (VCount=$FF) */
     if(vdp.mode <= 7)
+    {
+        STATS_BEGIN(STATS_OBJ);
         parse_line(0);
+        STATS_END(STATS_OBJ);
+    }
 
-    for(vdp.line = 0; vdp.line < lpf;)
+    /* The frame starts where the last one's final instruction ended */
+    sched.base = (uint32)z80_get_elapsed_cycles() - sched.carry;
+    sched.lines = lpf;
+    sched.hint = -1;
+    sched.vint = -1;
+    sched.stall = -1;
+    sched.audio = 0;
+    sched.skip_render = skip_render;
+    vdp.line = 0;
+
+    while((now = sched_now()) < end)
     {
-        z80_execute(227);
+        sched.end = next_event();
 
-        iline = iline_table[vdp.extended];
+        STATS_BEGIN(STATS_Z80);
+        TRACE_BEGIN(TRACE_Z80);
+        z80_execute(sched.end - now);
+        TRACE_END(TRACE_Z80, vdp.line);
+        STATS_END(STATS_Z80);
 
-        if(!skip_render)
-        {
-            render_line(vdp.line);
-        }
+        system_sync();
+        now = sched_now();
 
-        if(vdp.line <= iline)
+        if(sched.hint >= 0 && now >= sched.hint)
         {
-            vdp.left -= 1;
-            if(vdp.left == -1)
+            sched.hint = -1;
+            if(vdp.reg[0x00] & 0x10)
             {
-                vdp.left = vdp.reg[0x0A];
-                vdp.hint_pending = 1;
-
-                z80_execute(16);
-
-                if(vdp.reg[0x00] & 0x10)
-                {
-                    z80_set_irq_line(0, ASSERT_LINE);
-                }
+                TRACE_EVENT(TRACE_HINT, vdp.line - 1);
+                z80_set_irq_line(0, ASSERT_LINE);
             }
         }
-        else
-        {
-            vdp.left = vdp.reg[0x0A];
-        }
 
-        if(vdp.line == iline)
+        if(sched.vint >= 0 && now >= sched.vint)
         {
-            vdp.status |= 0x80;
-            vdp.vint_pending = 1;
-
-            z80_execute(16);
-
+            sched.vint = -1;
             if(vdp.reg[0x01] & 0x20)
             {
+                TRACE_EVENT(TRACE_VINT, vdp.line - 1);
                 z80_set_irq_line(0, ASSERT_LINE);
             }
         }
 
-        sound_update(vdp.line);
+        if(sched.stall >= 0 && now >= sched.stall)
+        {
+            /* Turn the clock back, the Z80 runs on up to here again */
+            sched.stall = -1;
+            sched.base += sched.hidden;
+        }
+    }
 
-        ++vdp.line;
+    /* Nothing runs past the end of the frame */
+    sched.end = 0;
+    sched.carry = now - end;
 
-        if(vdp.mode <= 7)
-            parse_line(vdp.line);
-    }
+    /* The pads can't have changed anything but a pause this frame */
+    lag.lagged = (lag.reads == 0);
+    lag.frames += lag.lagged;
+
+    TRACE_BEGIN(TRACE_AUDIO);
+    sound_update(lpf - 1);
+    TRACE_END(TRACE_AUDIO, lpf - 1);
+
+    TRACE_END(TRACE_FRAME, 0);
+    STATS_END(STATS_FRAME);
+    STATS_FRAME_END();
 }
 
 void system_reinit(void)
@@ -131,6 +355,7 @@ void system_init(void)
     vdp_init();
     render_init();
     sound_init();
+    STATS_RESET();
 
     sms.save = 0;
 }
@@ -185,6 +410,9 @@ void system_reset(void)
 
 void system_poweron(void)
 {
+    /* A state load resets the console too, but keeps the frame timing */
+    sched.carry = 0;
+    memset(&lag, 0, sizeof(lag_t));
     system_reset();
 }
 
@@ -193,5 +421,16 @@ void system_poweroff(void)
     system_manage_sram(cart.sram, SLOT_CART, SRAM_SAVE);
 }
 
+/* Give the Z80 'lines' hidden lines of extra time each frame, 0 for none */
+void system_overclock(int lines)
+{
+    if(lines < 0)
+        lines = 0;
+    if(lines > OVERCLOCK_MAX)
+        lines = OVERCLOCK_MAX;
+
+    sched.hidden = lines * CYCLES_PER_LINE;
+}
+
 
 
@@ -7,6 +7,9 @@
 
 #define PALETTE_SIZE        0x20
 
+/* Most hidden lines system_overclock() adds to a frame */
+#define OVERCLOCK_MAX       262
+
 /* Mask for removing unused pixel data */
 #define PIXEL_MASK          0x1F
 
@@ -37,6 +40,14 @@ typedef struct
     uint32 system;
 } input_t;
 
+/* Controller polling, kept apart from 'input' which the host clears */
+typedef struct
+{
+    uint32 reads;       /* Controller port reads in the running frame */
+    int lagged;         /* Set if the last frame read no controller port */
+    uint32 frames;      /* Lag frames since power-on */
+} lag_t;
+
 /* Game image structure */
 typedef struct
 {
@@ -72,9 +83,10 @@ typedef struct
 } bitmap_t;
 
 /* Global variables */
-extern bitmap_t bitmap;     /* Display bitmap */
-extern cart_t cart;         /* Game cartridge data */
-extern input_t input;       /* Controller input */
+extern THREAD_LOCAL bitmap_t bitmap; /* Display bitmap */
+extern THREAD_LOCAL cart_t cart;     /* Game cartridge data */
+extern THREAD_LOCAL input_t input;   /* Controller input */
+extern THREAD_LOCAL lag_t lag;       /* Lag frame detection */
 
 /* Function prototypes */
 void system_frame(int skip_render);
@@ -85,6 +97,14 @@ void system_reset(void);
 void system_manage_sram(uint8 *sram, int slot, int mode);
 void system_poweron(void);
 void system_poweroff(void);
+void system_overclock(int lines);
+
+/* Scanline scheduler, for the port handlers */
+void system_sync(void);
+int system_split(void);
+void system_sync_audio(void);
+void system_reschedule(void);
+int system_line_cycles(void);
 
 #endif /* _SYSTEM_H_ */
 
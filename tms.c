@@ -4,7 +4,7 @@
 */
 #include "shared.h"
 
-int text_counter;               /* Text offset counter */
+THREAD_LOCAL int text_counter;              /* Text offset counter */
 uint8 tms_lookup[16][256][2];   /* Expand BD, PG data into 8-bit pixels (G1,G2) */
 uint8 mc_lookup[16][256][8];    /* Expand BD, PG data into 8-bit pixels (MC) */
 uint8 txt_lookup[256][2];       /* Expand BD, PG data into 8-bit pixels (TX) */
@@ -23,8 +23,8 @@ typedef struct {
     uint8 sg[2];
 } tms_sprite;
 
-tms_sprite sprites[4];
-int sprites_found;
+THREAD_LOCAL tms_sprite sprites[4];
+THREAD_LOCAL int sprites_found;
 
 void parse_line(int line)
 {
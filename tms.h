@@ -1,7 +1,7 @@
 #ifndef _TMS_H_
 #define _TMS_H_
 
-extern int text_counter;
+extern THREAD_LOCAL int text_counter;
 
 
 void make_tms_tables(void);
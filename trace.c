@@ -0,0 +1,320 @@
+/*
+    trace.c --
+    Chrome trace-event export.
+
+    Events are stored in fixed size chunks. A full chunk is passed to a
+    writer thread, which formats it as JSON and writes it out, so the
+    emulation thread only pays for storing each event.
+*/
+#include "shared.h"
+
+#ifdef TRACE
+
+#ifdef LINUX
+#include <pthread.h>
+#endif
+
+#define TRACE_CHUNK         8192
+
+typedef struct
+{
+    int id;
+    int arg;
+    stats_tick_t start;
+    stats_tick_t length;
+} trace_event_t;
+
+typedef struct trace_chunk
+{
+    struct trace_chunk *next;
+    int count;
+    trace_event_t event[TRACE_CHUNK];
+} trace_chunk_t;
+
+typedef struct
+{
+    FILE *fd;
+    int tid;
+    int frame;
+    int written;
+    double ns_per_tick;
+    stats_tick_t origin;
+    trace_chunk_t *current;
+#ifdef LINUX
+    pthread_t writer;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    trace_chunk_t *head;
+    trace_chunk_t *tail;
+    int closing;
+#endif
+} trace_t;
+
+THREAD_LOCAL uint32 trace_mask = 0;
+THREAD_LOCAL stats_tick_t trace_start[TRACE_MAX];
+
+static THREAD_LOCAL trace_t *trace = NULL;
+static int trace_count = 0;
+
+static const char *trace_name[TRACE_MAX] = {
+    "frame", "line", "z80", "render", "audio", "hint", "vint", "mode", "bank"
+};
+
+
+static void write_event(trace_t *t, trace_event_t *e)
+{
+    double ts = (e->start - t->origin) * t->ns_per_tick / 1000.0;
+
+    fprintf(t->fd, "%s\n{\"name\":\"%s\",", t->written++ ? "," : "", trace_name[e->id]);
+
+    if(e->id <= TRACE_AUDIO)
+        fprintf(t->fd, "\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,", ts, e->length * t->ns_per_tick / 1000.0);
+    else
+        fprintf(t->fd, "\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,", ts);
+
+    fprintf(t->fd, "\"pid\":1,\"tid\":%d,\"args\":{", t->tid);
+
+    switch(e->id)
+    {
+        case TRACE_FRAME:
+            fprintf(t->fd, "\"frame\":%d}}", e->arg);
+            break;
+
+        case TRACE_MODE:
+            fprintf(t->fd, "\"mode\":%d}}", e->arg);
+            break;
+
+        case TRACE_BANK:
+            fprintf(t->fd, "\"register\":%d,\"value\":%d}}", e->arg >> 8, e->arg & 0xFF);
+            break;
+
+        default:
+            fprintf(t->fd, "\"line\":%d}}", e->arg);
+            break;
+    }
+}
+
+
+static void write_chunk(trace_t *t, trace_chunk_t *c)
+{
+    int i;
+
+    for(i = 0; i < c->count; i++)
+        write_event(t, &c->event[i]);
+
+    free(c);
+}
+
+
+#ifdef LINUX
+
+/* Write out chunks as they are handed over until the trace is closed */
+static void *trace_writer(void *arg)
+{
+    trace_t *t = (trace_t *)arg;
+
+    pthread_mutex_lock(&t->lock);
+
+    for(;;)
+    {
+        trace_chunk_t *c = t->head;
+
+        if(!c)
+        {
+            if(t->closing)
+                break;
+            pthread_cond_wait(&t->ready, &t->lock);
+            continue;
+        }
+
+        t->head = c->next;
+        if(!t->head)
+            t->tail = NULL;
+
+        pthread_mutex_unlock(&t->lock);
+        write_chunk(t, c);
+        pthread_mutex_lock(&t->lock);
+    }
+
+    pthread_mutex_unlock(&t->lock);
+    return NULL;
+}
+
+#endif
+
+
+/* Hand a chunk over for writing */
+static void submit(trace_t *t, trace_chunk_t *c)
+{
+#ifdef LINUX
+    c->next = NULL;
+
+    pthread_mutex_lock(&t->lock);
+    if(t->tail)
+        t->tail->next = c;
+    else
+        t->head = c;
+    t->tail = c;
+    pthread_cond_signal(&t->ready);
+    pthread_mutex_unlock(&t->lock);
+#else
+    write_chunk(t, c);
+#endif
+}
+
+
+static trace_event_t *new_event(void)
+{
+    trace_chunk_t *c = trace->current;
+
+    if(c->count == TRACE_CHUNK)
+    {
+        trace_chunk_t *n = malloc(sizeof(trace_chunk_t));
+
+        /* Drop events rather than stall if memory runs out */
+        if(!n)
+            return NULL;
+
+        n->count = 0;
+        submit(trace, c);
+        trace->current = c = n;
+    }
+
+    return &c->event[c->count++];
+}
+
+
+/* Start tracing the events in 'mask' for the console on this thread */
+int trace_open(char *filename, uint32 mask)
+{
+    trace_t *t;
+
+    if(trace)
+        return 0;
+
+    t = calloc(1, sizeof(trace_t));
+    if(!t)
+        return 0;
+
+    t->current = malloc(sizeof(trace_chunk_t));
+    t->fd = fopen(filename, "w");
+    if(!t->current || !t->fd)
+    {
+        if(t->fd)
+            fclose(t->fd);
+        free(t->current);
+        free(t);
+        return 0;
+    }
+
+    t->current->count = 0;
+    t->ns_per_tick = stats_tick_ns();
+    t->origin = stats_clock();
+#ifdef LINUX
+    t->tid = __sync_add_and_fetch(&trace_count, 1);
+    pthread_mutex_init(&t->lock, NULL);
+    pthread_cond_init(&t->ready, NULL);
+    if(pthread_create(&t->writer, NULL, trace_writer, t) != 0)
+    {
+        fclose(t->fd);
+        free(t->current);
+        free(t);
+        return 0;
+    }
+#else
+    t->tid = ++trace_count;
+#endif
+
+    fprintf(t->fd, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    fprintf(t->fd, "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+        "\"args\":{\"name\":\"console %d\"}}", t->tid, t->tid);
+    t->written = 1;
+
+    trace = t;
+    trace_mask = mask;
+    return 1;
+}
+
+
+/* Stop tracing and finish writing the file */
+void trace_close(void)
+{
+    trace_t *t = trace;
+
+    if(!t)
+        return;
+
+    trace_mask = 0;
+    trace = NULL;
+
+    submit(t, t->current);
+
+#ifdef LINUX
+    pthread_mutex_lock(&t->lock);
+    t->closing = 1;
+    pthread_cond_signal(&t->ready);
+    pthread_mutex_unlock(&t->lock);
+
+    pthread_join(t->writer, NULL);
+    pthread_mutex_destroy(&t->lock);
+    pthread_cond_destroy(&t->ready);
+#endif
+
+    fprintf(t->fd, "\n]}\n");
+    fclose(t->fd);
+    free(t);
+}
+
+
+/* Record a span that started at TRACE_BEGIN() and ends now */
+void trace_span(int id, int arg)
+{
+    stats_tick_t now = stats_clock();
+    trace_event_t *e = new_event();
+
+    if(id == TRACE_FRAME)
+        arg = trace->frame++;
+
+    if(!e)
+        return;
+
+    e->id = id;
+    e->arg = arg;
+    e->start = trace_start[id];
+    e->length = now - trace_start[id];
+}
+
+
+void trace_instant(int id, int arg)
+{
+    trace_event_t *e = new_event();
+
+    if(!e)
+        return;
+
+    e->id = id;
+    e->arg = arg;
+    e->start = stats_clock();
+    e->length = 0;
+}
+
+#else
+
+int trace_open(char *filename, uint32 mask)
+{
+    return 0;
+}
+
+void trace_close(void)
+{
+}
+
+void trace_span(int id, int arg)
+{
+}
+
+void trace_instant(int id, int arg)
+{
+}
+
+#endif /* TRACE */
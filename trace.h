@@ -0,0 +1,53 @@
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+/*
+    Chrome trace-event (JSON) export, readable by chrome://tracing and
+    Perfetto. Build with -DTRACE to include it; without it the TRACE_*
+    macros expand to nothing and trace_open() fails.
+*/
+
+/* Traced events */
+enum {
+    TRACE_FRAME = 0,        /* Span: system_frame() */
+    TRACE_LINE,             /* Span: the end-of-line work for one scanline */
+    TRACE_Z80,              /* Span: a Z80 time slice */
+    TRACE_RENDER,           /* Span: render_line() */
+    TRACE_AUDIO,            /* Span: sound_update() */
+    TRACE_HINT,             /* Instant: line interrupt asserted */
+    TRACE_VINT,             /* Instant: frame interrupt asserted */
+    TRACE_MODE,             /* Instant: VDP display mode changed */
+    TRACE_BANK,             /* Instant: mapper register written */
+    TRACE_MAX
+};
+
+/* Event masks for trace_open() */
+#define TRACE_MASK_FRAME    ((1 << TRACE_FRAME) | (1 << TRACE_HINT) | (1 << TRACE_VINT) | \
+                             (1 << TRACE_MODE) | (1 << TRACE_BANK))
+#define TRACE_MASK_ALL      ((1 << TRACE_MAX) - 1)
+
+#ifdef TRACE
+
+extern THREAD_LOCAL uint32 trace_mask;
+extern THREAD_LOCAL stats_tick_t trace_start[TRACE_MAX];
+
+#define TRACE_BEGIN(e)      do { if(trace_mask & (1 << (e))) trace_start[e] = stats_clock(); } while(0)
+#define TRACE_END(e, arg)   do { if(trace_mask & (1 << (e))) trace_span(e, arg); } while(0)
+#define TRACE_EVENT(e, arg) do { if(trace_mask & (1 << (e))) trace_instant(e, arg); } while(0)
+
+#else
+
+#define TRACE_BEGIN(e)
+#define TRACE_END(e, arg)
+#define TRACE_EVENT(e, arg)
+
+#endif /* TRACE */
+
+/* Function prototypes */
+int trace_open(char *filename, uint32 mask);
+void trace_close(void);
+void trace_span(int id, int arg);
+void trace_instant(int id, int arg);
+
+#endif /* _TRACE_H_ */
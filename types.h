@@ -4,15 +4,33 @@
 
 typedef unsigned char uint8;
 typedef unsigned short int uint16;
+#ifdef LINUX
+typedef unsigned int uint32;
+#else
 typedef unsigned long int uint32;
+#endif
 
 #ifdef PSP
 #include <psptypes.h>
 #else
 typedef signed char int8;
 typedef signed short int int16;
+#ifdef LINUX
+typedef signed int int32;
+#else
 typedef signed long int int32;
+#endif
 #endif
 
+/* Storage class for per-console state. Hosts that run several consoles
+   on separate threads give each thread its own copy. */
+#ifndef THREAD_LOCAL
+#ifdef LINUX
+#define THREAD_LOCAL __thread
+#else
+#define THREAD_LOCAL
+#endif
+#endif
+
 #endif /* __TYPES_H_ */
 
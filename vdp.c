@@ -25,9 +25,20 @@ static const uint8 tms_crom[] =
     bg_name_dirty[name] |= (1 << ((addr >> 2) & 7));       \
 }
 
+/* Mark rows of a pattern as dirty */
+#define MARK_BG_ROWS_DIRTY(name, rows)                     \
+{                                                          \
+    if(bg_name_dirty[name] == 0)                           \
+    {                                                      \
+        bg_name_list[bg_list_index] = name;                \
+        bg_list_index++;                                   \
+    }                                                      \
+    bg_name_dirty[name] |= rows;                           \
+}
+
 
 /* VDP context */
-vdp_t vdp;
+THREAD_LOCAL vdp_t vdp;
 
 
 /* Initialize VDP emulation */
@@ -65,8 +76,12 @@ void viewport_check(void)
     int m3 = (vdp.reg[1] >> 3) & 1;
     int m2 = (vdp.reg[0] >> 1) & 1;
     int m4 = (vdp.reg[0] >> 2) & 1;
+    int mode = (m4 << 3 | m3 << 2 | m2 << 1 | m1 << 0);
+
+    if(vdp.mode != mode)
+        TRACE_EVENT(TRACE_MODE, mode);
 
-    vdp.mode = (m4 << 3 | m3 << 2 | m2 << 1 | m1 << 0);
+    vdp.mode = mode;
 
     // check if this is switching out of tms
     if(!IS_GG)
@@ -185,22 +200,30 @@ void vdp_reg_w(uint8 r, uint8 d)
             if(vdp.hint_pending)
             {
                 if(d & 0x10)
+                {
+                    TRACE_EVENT(TRACE_HINT, vdp.line);
                     z80_set_irq_line(0, ASSERT_LINE);
+                }
                 else
                     z80_set_irq_line(0, CLEAR_LINE);
             }
             viewport_check();
+            system_reschedule();
             break;
 
         case 0x01: /* Mode Control No. 2 */
             if(vdp.vint_pending)
             {
                 if(d & 0x20)
+                {
+                    TRACE_EVENT(TRACE_VINT, vdp.line);
                     z80_set_irq_line(0, ASSERT_LINE);
+                }
                 else
                     z80_set_irq_line(0, CLEAR_LINE);
             }
             viewport_check();
+            system_reschedule();
             break;
 
         case 0x02: /* Name Table A Base Address */
@@ -298,6 +321,71 @@ void vdp_write(int offset, uint8 data)
     }
 }
 
+/* Write a run of bytes to the data port, as vdp_write() would */
+void vdp_write_block(const uint8 *src, int len)
+{
+    int index;
+
+    vdp.pending = 0;
+
+    if(vdp.code == 3)
+    {
+        /* CRAM write */
+        while(len--)
+        {
+            index = (vdp.addr & 0x1F);
+            if(*src != vdp.cram[index])
+            {
+                vdp.cram[index] = *src;
+                palette_sync(index, 0);
+            }
+            src++;
+            vdp.addr = (vdp.addr + 1) & 0x3FFF;
+        }
+        return;
+    }
+
+    /* VRAM write, a pattern at a time so each is marked dirty once */
+    while(len)
+    {
+        int name = (vdp.addr >> 5) & 0x1FF;
+        int count = 0x20 - (vdp.addr & 0x1F);
+        int rows = 0;
+
+        if(count > len)
+            count = len;
+        len -= count;
+
+        index = (vdp.addr & 0x3FFF);
+        vdp.addr = (vdp.addr + count) & 0x3FFF;
+
+        for(; count; count--, index++, src++)
+        {
+            if(*src != vdp.vram[index])
+            {
+                vdp.vram[index] = *src;
+                rows |= (1 << ((index >> 2) & 7));
+            }
+        }
+
+        if(rows)
+            MARK_BG_ROWS_DIRTY(name, rows);
+    }
+}
+
+/* Read a run of bytes from the data port, as vdp_read() would */
+void vdp_read_block(uint8 *dst, int len)
+{
+    vdp.pending = 0;
+
+    while(len--)
+    {
+        *dst++ = vdp.buffer;
+        vdp.buffer = vdp.vram[vdp.addr & 0x3FFF];
+        vdp.addr = (vdp.addr + 1) & 0x3FFF;
+    }
+}
+
 uint8 vdp_read(int offset)
 {
     uint8 temp;
@@ -335,7 +423,7 @@ uint8 vdp_counter_r(int offset)
             return vc_table[sms.display][vdp.extended][vdp.line & 0x1FF];
 
         case 1: /* H Counter */
-            pixel = (((z80_get_elapsed_cycles() % CYCLES_PER_LINE) / 4) * 3) * 2;
+            pixel = ((system_line_cycles() / 4) * 3) * 2;
             return hc_table[0][(pixel >> 1) & 0x01FF];
     }
 
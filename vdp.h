@@ -19,7 +19,10 @@
 #define MASTER_CLOCK        3579545
 #define LINES_PER_FRAME     262
 #define FRAMES_PER_SECOND   60
-#define CYCLES_PER_LINE     ((MASTER_CLOCK / FRAMES_PER_SECOND) / LINES_PER_FRAME)
+
+/* Z80 cycles per line, 342 pixels at 1.5 pixels per cycle. PAL lines
+   are as long, there are just 313 of them */
+#define CYCLES_PER_LINE     228
 
 /* VDP context */
 typedef struct
@@ -48,7 +51,7 @@ typedef struct
 } vdp_t;
 
 /* Global data */
-extern vdp_t vdp;
+extern THREAD_LOCAL vdp_t vdp;
 
 /* Function prototypes */
 void vdp_init(void);
@@ -57,6 +60,8 @@ void vdp_reset(void);
 uint8 vdp_counter_r(int offset);
 uint8 vdp_read(int offset);
 void vdp_write(int offset, uint8 data);
+void vdp_write_block(const uint8 *src, int len);
+void vdp_read_block(uint8 *dst, int len);
 void gg_vdp_write(int offset, uint8 data);
 void md_vdp_write(int offset, uint8 data);
 void tms_write(int offset, int data);